@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "src/concurrency/caching/async_cache_in_memory.hpp"
+#include "bench/perf_report.hpp"
+
+namespace {
+
+constexpr int num_keys = 1024;
+
+// Lookups of loaded keys, from one or several threads
+void BM_AsyncCacheHit(benchmark::State& state) {
+    static kcu::async_cache_in_memory<int, int> cache;
+    if (state.thread_index() == 0) {
+        for (int i = 0; i < num_keys; ++i) {
+            cache.get(i, [i]() { return i; }).wait();
+        }
+    }
+    int key = state.thread_index();
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get(key, []() { return 0; }));
+        key = (key + 1) % num_keys;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AsyncCacheHit)->ThreadRange(1, 4)->UseRealTime();
+
+// Misses on a full cache, each loading a value and evicting another
+void BM_AsyncCacheMissEvict(benchmark::State& state) {
+    kcu::async_cache_in_memory<int, int> cache(num_keys);
+    int key = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        cache.get(key, [key]() { return key; }).wait();
+        ++key;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AsyncCacheMissEvict)->UseRealTime();
+
+}  // namespace
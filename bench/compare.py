@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Compare two kcu_bench JSON outputs and flag regressions.
+
+Usage:
+    compare.py baseline.json current.json [--threshold 0.1] [--metric cpu_time]
+
+Benchmarks are matched by name. When run with --benchmark_repetitions, the
+median aggregate is compared. Exits with status 1 if any benchmark present in
+both files got slower by more than the threshold (a fraction, 0.1 = 10%).
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        benchmarks = json.load(f)["benchmarks"]
+
+    aggregated = any(b.get("run_type") == "aggregate" for b in benchmarks)
+    times = {}
+    for b in benchmarks:
+        if b.get("error_occurred"):
+            continue
+        if aggregated:
+            if b.get("aggregate_name") != "median":
+                continue
+            name = b["run_name"]
+        else:
+            name = b["name"]
+        times[name] = b[metric]
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="relative slowdown flagged as a regression")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"],
+                        default="real_time")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline, args.metric)
+    current = load(args.current, args.metric)
+
+    regressions = 0
+    width = max((len(name) for name in {**baseline, **current}), default=0)
+    for name, time in current.items():
+        if name not in baseline:
+            print(f"{name:<{width}}  {'new':>10}")
+            continue
+        base = baseline[name]
+        change = (time - base) / base if base else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<{width}}  {change:>+10.1%}{flag}")
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<{width}}  {'missing':>10}")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) slower than the baseline by more "
+              f"than {args.threshold:.0%}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
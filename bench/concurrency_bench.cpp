@@ -0,0 +1,359 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <new>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "src/concurrency/async_logger.hpp"
+#include "src/concurrency/future_chainer.hpp"
+#include "src/concurrency/hardware_interference_size.hpp"
+#include "src/concurrency/multicast_ring.hpp"
+#include "src/concurrency/seqlock.hpp"
+#include "src/concurrency/sharded_counter.hpp"
+#include "src/concurrency/snapshot.hpp"
+#include "src/concurrency/spsc_queue.hpp"
+#include "src/concurrency/thread_pool.hpp"
+#include "src/concurrency/timer_wheel.hpp"
+#include "src/profiling/tracing.hpp"
+#include "bench/latency_report.hpp"
+#include "bench/perf_report.hpp"
+
+namespace {
+
+// Schedule a batch of empty tasks and wait for all of them
+void BM_ThreadPoolSchedule(benchmark::State& state) {
+    kcu::thread_pool<4> tp;
+    std::vector<std::future<int>> futures(state.range(0));
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (auto& f : futures) {
+            f = tp.schedule([]() { return 1; });
+        }
+        for (auto& f : futures) {
+            benchmark::DoNotOptimize(f.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ThreadPoolSchedule)->Arg(1)->Arg(1000)->UseRealTime();
+
+// Latency from scheduling a task until a worker runs it, as percentiles
+void BM_ThreadPoolLatency(benchmark::State& state) {
+    kcu::thread_pool<4> tp;
+    kcu::hdr_histogram latency;
+    std::vector<std::future<void>> futures(state.range(0));
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (auto& f : futures) {
+            f = tp.schedule(
+                [&latency](std::chrono::steady_clock::time_point scheduled) {
+                    latency.record(std::chrono::steady_clock::now() -
+                                   scheduled);
+                },
+                std::chrono::steady_clock::now());
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    kcu::bench::report_latency(state, latency);
+}
+BENCHMARK(BM_ThreadPoolLatency)->Arg(1)->Arg(1000)->UseRealTime();
+
+void BM_SPSCQueuePushPop(benchmark::State& state) {
+    kcu::spsc_queue<int> q(1024);
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        q.push(1);
+        benchmark::DoNotOptimize(*q.front());
+        q.pop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SPSCQueuePushPop);
+
+// Items passed from a producer thread to the benchmark thread
+void BM_SPSCQueueTransfer(benchmark::State& state) {
+    constexpr std::size_t capacity = 1024;
+    constexpr int batch = 1 << 16;
+    kcu::spsc_queue<int> q(capacity);
+    std::atomic<bool> running = true;
+    std::thread producer([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            if (q.size() < capacity) {
+                q.push(1);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (int i = 0; i < batch; ++i) {
+            while (q.empty()) {
+                std::this_thread::yield();
+            }
+            benchmark::DoNotOptimize(*q.front());
+            q.pop();
+        }
+    }
+    running = false;
+    producer.join();
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_SPSCQueueTransfer)->UseRealTime();
+
+// The benchmark thread publishes each item to range(0) consumer threads,
+// through one multicast_ring or one spsc_queue per consumer
+void BM_MulticastRingFanOut(benchmark::State& state) {
+    constexpr int batch = 1 << 16;
+    kcu::multicast_ring<std::uint64_t> ring(1024);
+    std::atomic<bool> running = true;
+    std::vector<std::thread> consumers;
+    for (std::int64_t c = 0; c < state.range(0); ++c) {
+        consumers.emplace_back([&, &consumer = ring.add_consumer()]() {
+            std::uint64_t sum = 0;
+            const auto add = [&sum](const std::uint64_t& v) { sum += v; };
+            while (running.load(std::memory_order_relaxed)) {
+                if (! consumer.poll(add)) {
+                    std::this_thread::yield();
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+    }
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (std::uint64_t i = 0; i < batch; ++i) {
+            ring.publish(i);
+        }
+    }
+    running = false;
+    for (auto& t : consumers) {
+        t.join();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_MulticastRingFanOut)->DenseRange(1, 3)->UseRealTime();
+
+void BM_SPSCQueueFanOut(benchmark::State& state) {
+    constexpr std::size_t capacity = 1024;
+    constexpr int batch = 1 << 16;
+    std::vector<std::unique_ptr<kcu::spsc_queue<std::uint64_t>>> queues;
+    std::atomic<bool> running = true;
+    std::vector<std::thread> consumers;
+    for (std::int64_t c = 0; c < state.range(0); ++c) {
+        queues.push_back(
+            std::make_unique<kcu::spsc_queue<std::uint64_t>>(capacity));
+        consumers.emplace_back([&, &q = *queues.back()]() {
+            std::uint64_t sum = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (q.empty()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                sum += *q.front();
+                q.pop();
+            }
+            benchmark::DoNotOptimize(sum);
+        });
+    }
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (std::uint64_t i = 0; i < batch; ++i) {
+            for (auto& q : queues) {
+                while (q->size() >= capacity) {
+                    std::this_thread::yield();
+                }
+                q->push(std::uint64_t(i));
+            }
+        }
+    }
+    running = false;
+    for (auto& t : consumers) {
+        t.join();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_SPSCQueueFanOut)->DenseRange(1, 3)->UseRealTime();
+
+// Chain of then() continuations on a future, against std::async alone.
+// A continuation refers to the future it follows, so each is kept alive.
+void BM_FutureThen(benchmark::State& state) {
+    std::vector<kcu::future<int>> chain;
+    chain.reserve(state.range(0) + 1);
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        chain.clear();
+        chain.emplace_back(std::async([]() { return 0; }));
+        for (int i = 0; i < state.range(0); ++i) {
+            chain.push_back(chain.back().then([](int x) { return x + 1; }));
+        }
+        benchmark::DoNotOptimize(chain.back().get());
+    }
+}
+BENCHMARK(BM_FutureThen)->Arg(1)->Arg(8)->UseRealTime();
+
+void BM_StdAsync(benchmark::State& state) {
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        auto f = std::async([]() { return 0; });
+        benchmark::DoNotOptimize(f.get());
+    }
+}
+BENCHMARK(BM_StdAsync)->UseRealTime();
+
+// Latency of log() as seen by the caller, with the output discarded
+void BM_AsyncLoggerLog(benchmark::State& state) {
+    std::ostringstream sink;
+    auto* cout_buf = std::cout.rdbuf(sink.rdbuf());
+    {
+        kcu::async_logger logger;
+        const std::string message(64, 'x');
+        kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+            logger.log(message);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    std::cout.rdbuf(cout_buf);
+}
+BENCHMARK(BM_AsyncLoggerLog)->UseRealTime();
+
+// Counters of different threads on one cache line, or on their own lines
+template <std::size_t Alignment>
+struct alignas(Alignment) counter {
+    std::atomic<std::size_t> value = 0;
+};
+
+template <std::size_t Alignment>
+void BM_FalseSharing(benchmark::State& state) {
+    static counter<Alignment> counters[8];
+    auto& c = counters[state.thread_index() % 8];
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        c.value.store(c.value.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FalseSharing<alignof(std::atomic<std::size_t>)>)
+    ->ThreadRange(1, 4);
+BENCHMARK(BM_FalseSharing<kcu::hardware_destructive_interference_size>)
+    ->ThreadRange(1, 4);
+
+// One counter incremented by every thread, shared or sharded
+void BM_SharedAtomicCounter(benchmark::State& state) {
+    static std::atomic<std::uint64_t> counter = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedAtomicCounter)->ThreadRange(1, 4);
+
+void BM_ShardedCounter(benchmark::State& state) {
+    static kcu::sharded_counter counter;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        counter.add();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShardedCounter)->ThreadRange(1, 4);
+
+// Schedule and cancel a timer with range(0) other timers pending
+void BM_TimerWheelScheduleCancel(benchmark::State& state) {
+    kcu::timer_wheel wheel;
+    std::vector<kcu::timer_handle> pending;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        pending.push_back(
+            wheel.schedule_after(std::chrono::seconds(60 + i % 3600), []() {}));
+    }
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        auto handle = wheel.schedule_after(std::chrono::seconds(30), []() {});
+        benchmark::DoNotOptimize(handle.cancel());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheelScheduleCancel)->Arg(0)->Arg(1000000);
+
+// Read-mostly shared state: every thread reads, thread 0 also writes once
+// every 1024 reads
+struct bench_config {
+    std::uint64_t version = 0;
+    std::uint64_t limits[5] = {};
+};
+
+void BM_SharedMutexRead(benchmark::State& state) {
+    static std::shared_mutex mtx;
+    static bench_config config;
+    std::uint64_t i = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++i % 1024 == 0) {
+            std::unique_lock lock(mtx);
+            config.version = i;
+        } else {
+            std::shared_lock lock(mtx);
+            benchmark::DoNotOptimize(config.version);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedMutexRead)->ThreadRange(1, 4);
+
+void BM_SeqlockRead(benchmark::State& state) {
+    static kcu::seqlock<bench_config> config;
+    std::uint64_t i = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++i % 1024 == 0) {
+            config.store({i, {}});
+        } else {
+            benchmark::DoNotOptimize(config.load());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SeqlockRead)->ThreadRange(1, 4);
+
+void BM_SnapshotRead(benchmark::State& state) {
+    static kcu::snapshot<bench_config> config{bench_config{}};
+    std::uint64_t i = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++i % 1024 == 0) {
+            config.publish({i, {}});
+        } else {
+            benchmark::DoNotOptimize(config.read()->version);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotRead)->ThreadRange(1, 4);
+
+// Cost of a trace span with tracing stopped (0) and recording (1)
+void BM_TraceScope(benchmark::State& state) {
+    if (state.range(0)) {
+        kcu::tracing::start();
+    }
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        KCU_TRACE_SCOPE("bench::span");
+    }
+    kcu::tracing::stop();
+    kcu::tracing::clear();
+}
+BENCHMARK(BM_TraceScope)->Arg(0)->Arg(1);
+
+}  // namespace
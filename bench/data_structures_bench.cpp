@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include "src/data_structures/flat_hash_map.hpp"
+#include "src/data_structures/linked_list.hpp"
+#include "src/data_structures/unrolled_list.hpp"
+#include "bench/perf_report.hpp"
+
+namespace {
+
+template <typename List>
+void BM_ListPushBack(benchmark::State& state) {
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        List list;
+        for (int i = 0; i < state.range(0); ++i) {
+            list.push_back(int(i));
+        }
+        benchmark::DoNotOptimize(list.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListPushBack<kcu::linked_list<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_ListPushBack<kcu::unrolled_list<int>>)->Range(1 << 10, 1 << 20);
+
+template <typename List>
+void BM_ListTraverse(benchmark::State& state) {
+    List list;
+    for (int i = 0; i < state.range(0); ++i) {
+        list.push_back(int(i));
+    }
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        long sum = 0;
+        for (const int x : list) {
+            sum += x;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListTraverse<kcu::linked_list<int>>)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_ListTraverse<kcu::unrolled_list<int>>)->Range(1 << 10, 1 << 20);
+
+// Lookups of present keys, scattered over the table
+template <typename Map>
+void BM_MapFind(benchmark::State& state) {
+    const auto n = static_cast<std::uint64_t>(state.range(0));
+    const auto key = [](std::uint64_t i) { return i * 0x9e3779b97f4a7c15ull; };
+    Map map;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        map.try_emplace(key(i), i);
+    }
+    std::uint64_t i = 0;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(key(i)));
+        i = (i + 7919) % n;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapFind<kcu::flat_hash_map<std::uint64_t, std::uint64_t>>)
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_MapFind<std::unordered_map<std::uint64_t, std::uint64_t>>)
+    ->Range(1 << 10, 1 << 20);
+
+}  // namespace
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <vector>
+#include "src/io/io_executor.hpp"
+#include "bench/perf_report.hpp"
+
+namespace {
+
+constexpr std::size_t block = 4096;
+constexpr std::size_t file_blocks = 16384;
+
+// 64 MiB file of random blocks, kept in the page cache so that the
+// benchmarks measure the cost of issuing reads rather than the device
+class bench_file {
+   public:
+    bench_file()
+        : path_(std::filesystem::temp_directory_path() / "kcu_io_bench") {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        std::vector<std::byte> data(block * file_blocks, std::byte(1));
+        ::pwrite(fd_, data.data(), data.size(), 0);
+    }
+
+    ~bench_file() {
+        ::close(fd_);
+        std::filesystem::remove(path_);
+    }
+
+    int fd() const { return fd_; }
+
+   private:
+    std::filesystem::path path_;
+    int fd_;
+};
+
+// Random 4K reads, state.range(0) in flight at a time
+void random_reads(benchmark::State& state, kcu::io_backend backend) {
+    static bench_file file;
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    kcu::io_executor io(backend, unsigned(depth));
+    if (io.backend() != backend) {
+        state.SkipWithError("io_uring unavailable");
+        return;
+    }
+    std::vector<std::byte> bufs(block * depth);
+    std::vector<kcu::future<std::size_t>> batch;
+    batch.reserve(depth);
+    std::mt19937_64 rng(42);
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < depth; ++i) {
+            const std::span<std::byte> buf(bufs.data() + i * block, block);
+            batch.push_back(io.async_read(file.fd(), buf,
+                                          rng() % file_blocks * block));
+        }
+        for (auto& f : batch) {
+            benchmark::DoNotOptimize(f.get());
+        }
+        batch.clear();
+    }
+    // Items per second are IOPS
+    state.SetItemsProcessed(state.iterations() * std::int64_t(depth));
+    state.SetBytesProcessed(state.iterations() * std::int64_t(depth * block));
+}
+
+void BM_IoUringRandomRead(benchmark::State& state) {
+    random_reads(state, kcu::io_backend::io_uring);
+}
+BENCHMARK(BM_IoUringRandomRead)->Arg(1)->Arg(32);
+
+void BM_PreadThreadPoolRandomRead(benchmark::State& state) {
+    random_reads(state, kcu::io_backend::thread_pool);
+}
+BENCHMARK(BM_PreadThreadPoolRandomRead)->Arg(1)->Arg(32);
+
+}  // namespace
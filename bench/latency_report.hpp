@@ -0,0 +1,18 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include "src/profiling/hdr_histogram.hpp"
+
+namespace kcu::bench {
+
+// Add the percentiles of latencies recorded in nanoseconds to the benchmark's
+// counters, so runs report the tail rather than only the mean time
+inline void report_latency(benchmark::State& state,
+                           const hdr_histogram& latency) {
+    state.counters["p50_ns"] = double(latency.p50());
+    state.counters["p99_ns"] = double(latency.p99());
+    state.counters["p999_ns"] = double(latency.p999());
+    state.counters["max_ns"] = double(latency.max());
+}
+
+}  // namespace kcu::bench
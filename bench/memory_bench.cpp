@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include "src/memory/arena.hpp"
+#include "src/memory/concurrent_memory_pool.hpp"
+#include "src/memory/intrusive_ptr.hpp"
+#include "src/memory/pool_allocator.hpp"
+#include "bench/perf_report.hpp"
+
+namespace {
+
+constexpr std::size_t batch = 64;
+
+// Allocate a batch of blocks then free them, as a thread building and
+// dropping small nodes would
+template <typename Allocate, typename Deallocate>
+void allocate_batch(benchmark::State& state, Allocate&& allocate,
+                    Deallocate&& deallocate) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::array<void*, batch> blocks;
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (auto& p : blocks) {
+            p = allocate(size);
+            benchmark::DoNotOptimize(p);
+        }
+        for (auto* p : blocks) {
+            deallocate(p, size);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+void BM_OperatorNew(benchmark::State& state) {
+    allocate_batch(
+        state, [](std::size_t size) { return ::operator new(size); },
+        [](void* p, std::size_t) { ::operator delete(p); });
+}
+BENCHMARK(BM_OperatorNew)->Arg(16)->Arg(256)->ThreadRange(1, 4);
+
+void BM_ConcurrentMemoryPool(benchmark::State& state) {
+    static kcu::concurrent_memory_pool pool;
+    allocate_batch(
+        state, [](std::size_t size) { return pool.allocate(size); },
+        [](void* p, std::size_t size) { pool.deallocate(p, size); });
+}
+BENCHMARK(BM_ConcurrentMemoryPool)->Arg(16)->Arg(256)->ThreadRange(1, 4);
+
+void BM_MemoryPool(benchmark::State& state) {
+    static kcu::memory_pool<1 << 20> pool;
+    allocate_batch(
+        state, [](std::size_t size) { return pool.allocate(size); },
+        [](void* p, std::size_t) { pool.deallocate(p); });
+}
+BENCHMARK(BM_MemoryPool)->Arg(16)->Arg(256);
+
+// Bump allocation, released all at once
+void BM_Arena(benchmark::State& state) {
+    kcu::arena arena;
+    const auto size = static_cast<std::size_t>(state.range(0));
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            benchmark::DoNotOptimize(arena.allocate(size));
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_Arena)->Arg(16)->Arg(256);
+
+struct counted : kcu::intrusive_ref_counter<counted> {
+    int value = 1;
+};
+
+struct counted_local
+    : kcu::intrusive_ref_counter<counted_local,
+                                 kcu::ref_counting::non_atomic> {
+    int value = 1;
+};
+
+// Copy and drop a pointer to one object shared by all threads, so that the
+// reference count is contended
+template <typename Ptr>
+void copy_destroy(benchmark::State& state, const Ptr& shared) {
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        Ptr copy = shared;
+        benchmark::DoNotOptimize(copy->value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SharedPtrCopy(benchmark::State& state) {
+    static const auto shared = std::make_shared<counted>();
+    copy_destroy(state, shared);
+}
+BENCHMARK(BM_SharedPtrCopy)->ThreadRange(1, 4);
+
+void BM_IntrusivePtrCopy(benchmark::State& state) {
+    static const auto shared = kcu::make_intrusive<counted>();
+    copy_destroy(state, shared);
+}
+BENCHMARK(BM_IntrusivePtrCopy)->ThreadRange(1, 4);
+
+void BM_IntrusivePtrNonAtomicCopy(benchmark::State& state) {
+    const auto local = kcu::make_intrusive<counted_local>();
+    copy_destroy(state, local);
+}
+BENCHMARK(BM_IntrusivePtrNonAtomicCopy);
+
+// Creating and dropping the only reference
+void BM_MakeShared(benchmark::State& state) {
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::make_shared<counted>());
+    }
+}
+BENCHMARK(BM_MakeShared);
+
+void BM_MakeIntrusive(benchmark::State& state) {
+    kcu::bench::perf_report perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kcu::make_intrusive<counted>());
+    }
+}
+BENCHMARK(BM_MakeIntrusive);
+
+}  // namespace
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <optional>
+#include <string>
+#include "src/profiling/perf_scope.hpp"
+
+namespace kcu::bench {
+
+// Hardware counters of the benchmark thread, from construction until the
+// benchmark loop finishes, added to the benchmark's counters as IPC and
+// per iteration misses. Declare it just before the loop. Counters the kernel
+// does not allow are left out.
+class perf_report {
+   public:
+    explicit perf_report(benchmark::State& state) : state_(state) {}
+    perf_report(const perf_report&) = delete;
+    perf_report& operator=(const perf_report&) = delete;
+
+    ~perf_report() {
+        const auto counts = scope_.counts();
+        if (const auto ipc = counts.ipc()) {
+            state_.counters["IPC"] = average(*ipc);
+        }
+        per_iteration("cache_misses/op", counts.cache_misses);
+        per_iteration("branch_misses/op", counts.branch_misses);
+        per_iteration("ctx_switches/op", counts.context_switches);
+    }
+
+   private:
+    // Each thread reports its own counts, averaged over threads
+    static benchmark::Counter average(double value) {
+        return benchmark::Counter(value, benchmark::Counter::kAvgThreads);
+    }
+
+    void per_iteration(const std::string& name,
+                       const std::optional<std::uint64_t>& count) {
+        if (count && state_.iterations() > 0) {
+            state_.counters[name] =
+                average(double(*count) / double(state_.iterations()));
+        }
+    }
+
+    benchmark::State& state_;
+    perf_scope scope_;
+};
+
+}  // namespace kcu::bench
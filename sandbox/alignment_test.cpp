@@ -9,18 +9,11 @@
 #include <thread>
 #include <vector>
 #include <version>
+#include "src/concurrency/hardware_interference_size.hpp"
 
 namespace {
 
-#ifdef __cpp_lib_hardware_interference_size
-constexpr std::size_t hardware_constructive_interference_size =
-    std::hardware_constructive_interference_size;
-constexpr std::size_t hardware_destructive_interference_size =
-    std::hardware_destructive_interference_size;
-#else
-constexpr std::size_t hardware_constructive_interference_size = 64;
-constexpr std::size_t hardware_destructive_interference_size = 64;
-#endif
+using kcu::hardware_destructive_interference_size;
 
 struct align_base {
     std::size_t counter_ = 0;
@@ -0,0 +1,131 @@
+#include "src/memory/allocation_profiler.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace kcu;
+
+namespace {
+
+struct profiled : allocation_profiler<profiled> {
+    char payload[24];
+};
+
+struct sampled : allocation_profiler<sampled> {
+    char payload[100];
+};
+
+struct threaded : allocation_profiler<threaded> {
+    int x = 0;
+};
+
+struct plain {
+    char payload[24];
+};
+
+struct timed : allocation_profiler<timed> {
+    char payload[24];
+};
+
+}  // namespace
+
+TEST(AllocationProfiler, Counts) {
+    auto& profile = profiled::profile();
+    EXPECT_EQ(profile.name(), "(anonymous namespace)::profiled");
+
+    std::vector<std::unique_ptr<profiled>> objects;
+    for (int i = 0; i < 10; ++i) {
+        objects.push_back(std::make_unique<profiled>());
+    }
+    auto stats = profile.stats();
+    EXPECT_EQ(stats.allocations, 10);
+    EXPECT_EQ(stats.deallocations, 0);
+    EXPECT_EQ(stats.bytes, 10 * sizeof(profiled));
+    EXPECT_EQ(stats.live_bytes, 10 * sizeof(profiled));
+    EXPECT_EQ(stats.size_histogram[std::bit_width(sizeof(profiled))], 10);
+
+    objects.resize(4);
+    stats = profile.stats();
+    EXPECT_EQ(stats.deallocations, 6);
+    EXPECT_EQ(stats.live_bytes, 4 * sizeof(profiled));
+    EXPECT_EQ(stats.peak_live_bytes, 10 * sizeof(profiled));
+
+    auto* array = new profiled[8];
+    delete[] array;
+    stats = profile.stats();
+    EXPECT_EQ(stats.allocations, 11);
+    EXPECT_EQ(stats.live_bytes, 4 * sizeof(profiled));
+}
+
+TEST(AllocationProfiler, Threads) {
+    constexpr int num_threads = 4;
+    constexpr int num_allocations = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < num_allocations; ++i) {
+                delete new threaded;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const auto stats = threaded::profile().stats();
+    EXPECT_EQ(stats.allocations, num_threads * num_allocations);
+    EXPECT_EQ(stats.deallocations, num_threads * num_allocations);
+    EXPECT_EQ(stats.live_bytes, 0);
+    EXPECT_LE(stats.peak_live_bytes, num_threads * sizeof(threaded));
+}
+
+TEST(AllocationProfiler, SampledReport) {
+    auto& profile = sampled::profile();
+    profile.set_sample_rate(4);
+    for (int i = 0; i < 16; ++i) {
+        delete new sampled;
+    }
+    profile.set_sample_rate(0);
+
+    std::ostringstream report;
+    profile.report(report);
+    const auto text = report.str();
+    EXPECT_NE(text.find("(anonymous namespace)::sampled: 16 allocations"),
+              std::string::npos);
+    EXPECT_NE(text.find("< 128 bytes: 16"), std::string::npos);
+    EXPECT_NE(text.find("sampled 4 allocations, 400 bytes"),
+              std::string::npos);
+
+    std::ostringstream all;
+    allocation_profile::report_all(all);
+    EXPECT_NE(all.str().find(text), std::string::npos);
+}
+
+TEST(AllocationProfiler, Perf) {
+    constexpr int num_allocations = 1 << 22;
+
+    const auto time = [](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_allocations; ++i) {
+            T* volatile p = new T;
+            delete p;
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / num_allocations;
+    };
+
+    const double plain_ns = time(static_cast<plain*>(nullptr));
+    const double profiled_ns = time(static_cast<timed*>(nullptr));
+    timed::profile().set_sample_rate(1024);
+    const double sampled_ns = time(static_cast<timed*>(nullptr));
+    timed::profile().set_sample_rate(0);
+
+    std::cout << "new/delete: " << plain_ns
+              << "ns, profiled: " << profiled_ns
+              << "ns, sampled 1 in 1024: " << sampled_ns << "ns" << std::endl;
+}
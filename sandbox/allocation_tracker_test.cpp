@@ -0,0 +1,91 @@
+#include "src/memory/allocation_tracker.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace kcu;
+
+namespace {
+
+struct alignas(128) over_aligned {
+    char x[128];
+};
+
+}  // namespace
+
+TEST(AllocationTracker, ThisThread) {
+    const auto before = allocation_tracker::this_thread();
+    {
+        auto p = std::make_unique<std::vector<int>>(1000);
+        auto q = std::make_unique<over_aligned>();
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(q.get()) % 128, 0);
+
+        const auto during = allocation_tracker::this_thread();
+        EXPECT_EQ(during.allocations - before.allocations, 3);
+        EXPECT_GE(during.bytes_allocated - before.bytes_allocated,
+                  1000 * sizeof(int) + sizeof(over_aligned));
+        EXPECT_GE(during.live_bytes() - before.live_bytes(),
+                  static_cast<std::int64_t>(1000 * sizeof(int)));
+        EXPECT_GE(during.peak_bytes, during.live_bytes());
+    }
+    const auto after = allocation_tracker::this_thread();
+    EXPECT_EQ(after.deallocations - before.deallocations, 3);
+    EXPECT_EQ(after.live_bytes(), before.live_bytes());
+}
+
+TEST(AllocationTracker, Total) {
+    constexpr int num_threads = 4;
+    static constexpr int num_allocations = 1000;
+    const auto before = allocation_tracker::total();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([]() {
+            const auto start = allocation_tracker::this_thread();
+            for (int i = 0; i < num_allocations; ++i) {
+                int* volatile p = new int(i);
+                delete p;
+            }
+            const auto end = allocation_tracker::this_thread();
+            EXPECT_EQ(end.allocations - start.allocations, num_allocations);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // Counts of exited threads are kept
+    const auto after = allocation_tracker::total();
+    EXPECT_GE(after.allocations - before.allocations,
+              num_threads * num_allocations);
+    EXPECT_GE(after.deallocations - before.deallocations,
+              num_threads * num_allocations);
+}
+
+TEST(AllocationTracker, NoAllocScope) {
+    no_alloc_scope scope;
+    std::vector<int> v;
+    v.reserve(16);
+    EXPECT_EQ(scope.allocations(), 1);
+    {
+        no_alloc_scope inner;
+        for (int i = 0; i < 16; ++i) {
+            v.push_back(i);
+        }
+        EXPECT_EQ(inner.allocations(), 0);
+    }
+    v.push_back(16);
+    EXPECT_EQ(scope.allocations(), 2);
+}
+
+TEST(AllocationTrackerDeathTest, NoAllocScopeAbort) {
+    EXPECT_DEATH(
+        {
+            no_alloc_scope scope(true);
+            int* volatile p = new int(1);
+            delete p;
+        },
+        "heap allocation in scope");
+}
@@ -0,0 +1,123 @@
+#include "src/memory/arena.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kcu;
+
+TEST(Arena, BumpAllocates) {
+    arena a(4096);
+    auto* p1 = static_cast<char*>(a.allocate(16));
+    auto* p2 = static_cast<char*>(a.allocate(16));
+    EXPECT_EQ(p2 - p1, 16);
+
+    for (std::size_t align = 1; align <= 4096; align *= 2) {
+        void* p = a.allocate(3, align);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % align, 0);
+    }
+}
+
+TEST(Arena, ZeroSizeAllocation) {
+    arena a;
+    EXPECT_NE(a.allocate(0), nullptr);
+    std::pmr::memory_resource& resource = a;
+    EXPECT_NE(resource.allocate(0, 64), nullptr);
+}
+
+TEST(Arena, GrowsAndResets) {
+    arena a(4096);
+    std::vector<char*> first_pass;
+    for (int i = 0; i < 1000; ++i) {
+        first_pass.push_back(static_cast<char*>(a.allocate(100)));
+    }
+    // Larger than any chunk so far
+    first_pass.push_back(static_cast<char*>(a.allocate(1 << 20)));
+    const std::size_t capacity = a.capacity();
+    EXPECT_GE(capacity, 1000 * 100 + (1 << 20));
+
+    // Same allocations after a reset reuse the same chunks
+    a.reset();
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(a.allocate(100), first_pass[i]);
+    }
+    EXPECT_EQ(a.allocate(1 << 20), first_pass.back());
+    EXPECT_EQ(a.capacity(), capacity);
+}
+
+TEST(Arena, HugePages) {
+    arena a(1, true);
+    auto* p = static_cast<char*>(a.allocate(1 << 22));
+    p[0] = 1;
+    p[(1 << 22) - 1] = 1;
+    EXPECT_EQ(a.capacity() % (2 * 1024 * 1024), 0);
+}
+
+TEST(Arena, MemoryResource) {
+    arena a;
+    std::pmr::vector<std::pmr::string> strings(&a);
+    for (int i = 0; i < 100; ++i) {
+        strings.emplace_back("A string long enough to not fit in the SSO " +
+                             std::to_string(i));
+    }
+    EXPECT_EQ(strings[42], "A string long enough to not fit in the SSO 42");
+    EXPECT_EQ(strings.get_allocator().resource(), &a);
+}
+
+TEST(Arena, Allocator) {
+    arena a;
+    std::map<int, int, std::less<int>,
+             arena_allocator<std::pair<const int, int>>>
+        m{arena_allocator<std::pair<const int, int>>(a)};
+    for (int i = 0; i < 100; ++i) {
+        m.emplace(i, i);
+    }
+    EXPECT_EQ(m.size(), 100);
+    EXPECT_EQ(m.at(42), 42);
+}
+
+// Allocate a request's worth of objects then release them all
+TEST(Arena, Perf) {
+    constexpr int num_requests = 1 << 12;
+    constexpr int allocations_per_request = 256;
+    std::vector<std::size_t> sizes(allocations_per_request);
+    std::mt19937 rng(42);
+    for (auto& s : sizes) {
+        s = 16 + rng() % 240;
+    }
+
+    const auto time = [&](auto&& request) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_requests; ++i) {
+            request();
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (num_requests * allocations_per_request);
+    };
+
+    arena a;
+    std::vector<void*> live(allocations_per_request);
+    const double arena_ns = time([&]() {
+        for (int j = 0; j < allocations_per_request; ++j) {
+            live[j] = a.allocate(sizes[j]);
+        }
+        a.reset();
+    });
+    const double malloc_ns = time([&]() {
+        for (int j = 0; j < allocations_per_request; ++j) {
+            live[j] = std::malloc(sizes[j]);
+        }
+        for (void* p : live) {
+            std::free(p);
+        }
+    });
+    std::cout << "arena: " << arena_ns << "ns/allocation, malloc: "
+              << malloc_ns << "ns/allocation" << std::endl;
+}
@@ -1,9 +1,17 @@
 #include <gtest/gtest.h>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
 #include <string>
 #include <thread>
+#include <vector>
 #include "src/concurrency/caching/async_cache_in_memory.hpp"
+#include "src/concurrency/caching/async_cache_persistent.hpp"
 
 using namespace kcu;
 
@@ -28,3 +36,293 @@ TEST(AsyncCacheInMemory, RetrievesValueAsync) {
     // Check that both results are the same (indicating cached result)
     EXPECT_EQ(result1, result2);
 }
+
+namespace {
+
+std::filesystem::path cache_file(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("kcu_" + name);
+    std::filesystem::remove(path);
+    return path;
+}
+
+}  // namespace
+
+TEST(AsyncCachePersistent, RetrievesValueAfterRestart) {
+    const auto path = cache_file("restart.cache");
+    std::atomic<int> evaluations = 0;
+    const auto eval = [&evaluations](int i) {
+        return [&evaluations, i]() {
+            ++evaluations;
+            return "Value " + std::to_string(i);
+        };
+    };
+
+    {
+        async_cache_persistent<int, std::string> async_cache(path, 64);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(async_cache.get(i, eval(i)).get(),
+                      "Value " + std::to_string(i));
+        }
+        EXPECT_EQ(async_cache.size(), 100);
+    }
+    EXPECT_EQ(evaluations, 100);
+
+    {
+        async_cache_persistent<int, std::string> async_cache(path);
+        EXPECT_EQ(async_cache.size(), 100);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(async_cache.get(i, eval(-1)).get(),
+                      "Value " + std::to_string(i));
+        }
+    }
+    EXPECT_EQ(evaluations, 100);
+
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncCachePersistent, FailedEvaluationIsNotPersisted) {
+    const auto path = cache_file("failed.cache");
+    async_cache_persistent<int, double> async_cache(path);
+
+    auto task = async_cache.get(
+        0, []() -> double { throw std::runtime_error("Threw"); });
+    EXPECT_THROW(task.get(), std::runtime_error);
+    EXPECT_EQ(async_cache.size(), 0);
+    EXPECT_EQ(async_cache.get(0, []() { return 1.5; }).get(), 1.5);
+
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncCachePersistent, RejectsForeignFile) {
+    const auto path = cache_file("foreign.cache");
+    {
+        std::ofstream out(path);
+        out << "Not a cache file, but long enough to hold a file header";
+    }
+    using cache = async_cache_persistent<int, int>;
+    EXPECT_THROW(cache async_cache(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncCachePersistent, RejectsCorruptRecords) {
+    const auto path = cache_file("corrupt.cache");
+    {
+        async_cache_persistent<int, std::string> async_cache(path, 4096);
+        async_cache.get(1, []() { return "One"; }).get();
+        async_cache.get(2, []() { return "Two"; }).get();
+    }
+    const auto record_offset = [](int record) {
+        // file_header is magic, version and end; records of int keys and
+        // 3 character values are 24 bytes once padded
+        return std::streamoff(24 + 24 * record);
+    };
+    const auto overwrite = [&path](std::streamoff offset, std::uint64_t v) {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    };
+    using cache = async_cache_persistent<int, std::string>;
+
+    // Value size running past the end of the committed records
+    overwrite(record_offset(1) + 8, 1 << 20);
+    EXPECT_THROW(cache async_cache(path), std::runtime_error);
+    // Key size which would wrap the offset around
+    overwrite(record_offset(1) + 8, 3);
+    overwrite(record_offset(0), ~std::uint64_t(0) - 8);
+    EXPECT_THROW(cache async_cache(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncCacheTiered, PromotesFromPersistentTier) {
+    const auto path = cache_file("tiered.cache");
+    {
+        async_cache_persistent<int, std::string> async_cache(path);
+        async_cache.get(0, []() { return "Persisted"; }).get();
+    }
+
+    auto l2 = std::make_shared<async_cache_persistent<int, std::string>>(path);
+    async_cache_in_memory<int, std::string> async_cache(l2);
+
+    // Hit in the persistent tier
+    EXPECT_EQ(async_cache.get(0, []() { return "Evaluated"; }).get(),
+              "Persisted");
+    // Miss in both tiers, evaluated and written through to the persistent tier
+    EXPECT_EQ(async_cache.get(1, []() { return "Evaluated"; }).get(),
+              "Evaluated");
+    EXPECT_EQ(l2->size(), 2);
+
+    std::filesystem::remove(path);
+}
+
+// Expect reading back from a warm data file to be much faster than
+// re-evaluating every value
+TEST(AsyncCachePersistent, Perf) {
+    const auto path = cache_file("perf.cache");
+    constexpr int num_keys = 100;
+    const auto expensive = [](int i) {
+        return [i]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return i;
+        };
+    };
+    const auto time_all = [&](auto& async_cache) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_keys; ++i) {
+            EXPECT_EQ(async_cache.get(i, expensive(i)).get(), i);
+        }
+        return std::chrono::steady_clock::now() - start;
+    };
+
+    std::chrono::nanoseconds cold;
+    std::chrono::nanoseconds warm;
+    {
+        async_cache_persistent<int, int> async_cache(path);
+        cold = time_all(async_cache);
+    }
+    {
+        async_cache_persistent<int, int> async_cache(path);
+        warm = time_all(async_cache);
+    }
+    std::cout << "Cold: " << cold.count() << "ns, warm restart: "
+              << warm.count() << "ns" << std::endl;
+    EXPECT_LT(warm, cold);
+
+    std::filesystem::remove(path);
+}
+
+TEST(AsyncCacheInMemory, Stats) {
+    async_cache_in_memory<int, int> async_cache;
+    const auto slow = []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return 1;
+    };
+
+    auto task1 = async_cache.get(0, slow);
+    // Still loading, so waits on the same future
+    auto task2 = async_cache.get(0, slow);
+    EXPECT_EQ(async_cache.stats().in_flight_loads, 1);
+    task1.get();
+    task2.get();
+    async_cache.get(0, slow).get();
+    async_cache.get(1, []() { return 2; }).get();
+
+    const auto stats = async_cache.stats();
+    EXPECT_EQ(stats.hits, 2);
+    EXPECT_EQ(stats.coalesced_waits, 1);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_EQ(stats.in_flight_loads, 0);
+    EXPECT_EQ(std::accumulate(stats.load_time_histogram.begin(),
+                              stats.load_time_histogram.end(), 0UL),
+              2);
+    // The slow load takes at least 50ms = 2^15.6us
+    EXPECT_EQ(std::accumulate(stats.load_time_histogram.begin() + 16,
+                              stats.load_time_histogram.end(), 0UL),
+              1);
+
+    std::uint64_t shard_misses = 0;
+    for (const auto& shard : async_cache.shard_stats()) {
+        shard_misses += shard.misses;
+    }
+    EXPECT_EQ(shard_misses, 2);
+}
+
+TEST(AsyncCacheInMemory, EvictsLeastRecentlyUsed) {
+    // One shard so that the capacity applies to all keys
+    async_cache_in_memory<int, int, 1> async_cache(3);
+    int loads = 0;
+    const auto load = [&loads](int i) {
+        return [&loads, i]() {
+            ++loads;
+            return i;
+        };
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        async_cache.get(i, load(i)).get();
+    }
+    // Use 0, so 1 is the least recently used
+    async_cache.get(0, load(0)).get();
+    async_cache.get(3, load(3)).get();
+    EXPECT_EQ(async_cache.stats().evictions, 1);
+    EXPECT_EQ(loads, 4);
+
+    async_cache.get(0, load(0)).get();
+    async_cache.get(2, load(2)).get();
+    async_cache.get(3, load(3)).get();
+    EXPECT_EQ(loads, 4);
+    EXPECT_EQ(async_cache.get(1, load(1)).get(), 1);
+    EXPECT_EQ(loads, 5);
+
+    const auto stats = async_cache.stats();
+    EXPECT_EQ(stats.evictions, 2);
+    EXPECT_EQ(stats.misses, 5);
+}
+
+TEST(AsyncCacheInMemory, DoesNotEvictLoadingEntries) {
+    async_cache_in_memory<int, int, 1> async_cache(1);
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+
+    auto slow = async_cache.get(0, [gate]() {
+        gate.wait();
+        return 0;
+    });
+    async_cache.get(1, []() { return 1; }).get();
+    // 0 is still loading, so 1 cannot be evicted for it either
+    EXPECT_EQ(async_cache.stats().evictions, 0);
+
+    release.set_value();
+    slow.get();
+    async_cache.get(2, []() { return 2; }).get();
+    EXPECT_EQ(async_cache.stats().evictions, 2);
+}
+
+TEST(AsyncCachePersistent, Stats) {
+    const auto path = cache_file("stats.cache");
+    {
+        async_cache_persistent<int, int> async_cache(path);
+        async_cache.get(0, []() { return 1; }).get();
+    }
+    async_cache_persistent<int, int> async_cache(path);
+    async_cache.get(0, []() { return 1; }).get();
+    async_cache.get(1, []() { return 2; }).get();
+
+    const auto stats = async_cache.stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.in_flight_loads, 0);
+
+    std::filesystem::remove(path);
+}
+
+// Hit throughput from several threads, mostly on distinct shards
+TEST(AsyncCacheInMemory, Perf) {
+    constexpr int num_threads = 4;
+    constexpr int num_gets = 1 << 18;
+    async_cache_in_memory<int, int> async_cache;
+    for (int i = 0; i < num_threads; ++i) {
+        async_cache.get(i, [i]() { return i; }).get();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&async_cache, i]() {
+            for (int j = 0; j < num_gets; ++j) {
+                async_cache.get(i, [i]() { return i; });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "Hits/s: " << num_threads * num_gets / elapsed.count()
+              << std::endl;
+    EXPECT_EQ(async_cache.stats().hits, num_threads * num_gets);
+}
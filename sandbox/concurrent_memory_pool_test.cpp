@@ -0,0 +1,184 @@
+#include "src/memory/concurrent_memory_pool.hpp"
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace kcu;
+
+namespace {
+
+// Hands pointers from one thread to another
+class handoff {
+   public:
+    void put(void* p) {
+        auto& slot = slots_[write_++ % slots_.size()];
+        while (slot.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        slot.store(p, std::memory_order_release);
+    }
+
+    void* take() {
+        auto& slot = slots_[read_++ % slots_.size()];
+        void* p;
+        while (! (p = slot.load(std::memory_order_acquire))) {
+            std::this_thread::yield();
+        }
+        slot.store(nullptr, std::memory_order_release);
+        return p;
+    }
+
+   private:
+    std::array<std::atomic<void*>, 1024> slots_{};
+    std::size_t write_ = 0;
+    std::size_t read_ = 0;
+};
+
+}  // namespace
+
+TEST(ConcurrentMemoryPool, AllocatesAndDeallocates) {
+    concurrent_memory_pool pool;
+    std::vector<std::pair<char*, std::size_t>> blocks;
+    for (std::size_t size = 1; size <= 2 * concurrent_memory_pool::max_size;
+         size += 7) {
+        char* p = static_cast<char*>(pool.allocate(size));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 16, 0);
+        std::memset(p, static_cast<char>(size), size);
+        blocks.emplace_back(p, size);
+    }
+    for (auto [p, size] : blocks) {
+        for (std::size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(p[i], static_cast<char>(size));
+        }
+        pool.deallocate(p, size);
+    }
+
+    // Freed blocks are reused
+    void* p = pool.allocate(64);
+    pool.deallocate(p, 64);
+    EXPECT_EQ(pool.allocate(64), p);
+    pool.deallocate(p, 64);
+}
+
+TEST(ConcurrentMemoryPool, CrossThreadFreeReturnsToOwner) {
+    concurrent_memory_pool pool;
+    constexpr std::size_t num_blocks = 256;
+
+    std::vector<void*> blocks;
+    for (std::size_t i = 0; i < num_blocks; ++i) {
+        blocks.push_back(pool.allocate(32));
+    }
+    std::thread([&]() {
+        for (void* p : blocks) {
+            pool.deallocate(p, 32);
+        }
+    }).join();
+
+    std::set<void*> freed(blocks.begin(), blocks.end());
+    std::set<void*> reused;
+    for (std::size_t i = 0; i < num_blocks; ++i) {
+        reused.insert(pool.allocate(32));
+    }
+    EXPECT_EQ(freed, reused);
+    for (void* p : reused) {
+        pool.deallocate(p, 32);
+    }
+}
+
+TEST(ConcurrentMemoryPool, Stress) {
+    concurrent_memory_pool pool;
+    constexpr int num_pairs = 4;
+    constexpr int num_ops = 20000;
+
+    std::vector<std::thread> threads;
+    std::vector<handoff> handoffs(num_pairs);
+    std::atomic<int> corrupt = 0;
+    for (int i = 0; i < num_pairs; ++i) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 rng(i);
+            for (int j = 0; j < num_ops; ++j) {
+                const std::size_t size = 8 + rng() % 512;
+                auto* p = static_cast<unsigned char*>(pool.allocate(size));
+                std::memset(p, static_cast<unsigned char>(size), size);
+                p[0] = static_cast<unsigned char>(size >> 8);
+                handoffs[i].put(p);
+            }
+        });
+        threads.emplace_back([&, i]() {
+            std::mt19937 rng(i);
+            for (int j = 0; j < num_ops; ++j) {
+                const std::size_t size = 8 + rng() % 512;
+                auto* p = static_cast<unsigned char*>(handoffs[i].take());
+                if (p[0] != static_cast<unsigned char>(size >> 8) ||
+                    p[size - 1] != static_cast<unsigned char>(size)) {
+                    ++corrupt;
+                }
+                pool.deallocate(p, size);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(corrupt, 0);
+}
+
+// Producer / consumer pairs: allocate on one thread, free on another
+TEST(ConcurrentMemoryPool, Perf) {
+    constexpr int total_ops = 1 << 17;
+    concurrent_memory_pool pool;
+
+    const auto run = [&](int num_threads, auto allocate, auto deallocate) {
+        const int num_pairs = std::max(num_threads / 2, 1);
+        const int num_ops = total_ops / num_pairs;
+        std::vector<handoff> handoffs(num_pairs);
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        if (num_threads == 1) {
+            for (int j = 0; j < total_ops; ++j) {
+                // Stop the compiler eliding the malloc / free pair
+                void* volatile p = allocate(64);
+                deallocate(p, 64);
+            }
+        } else {
+            for (int i = 0; i < num_pairs; ++i) {
+                threads.emplace_back([&, i]() {
+                    for (int j = 0; j < num_ops; ++j) {
+                        handoffs[i].put(allocate(64));
+                    }
+                });
+                threads.emplace_back([&, i]() {
+                    for (int j = 0; j < num_ops; ++j) {
+                        deallocate(handoffs[i].take(), 64);
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / total_ops;
+    };
+
+    for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+        const double pool_ns = run(
+            num_threads, [&](std::size_t n) { return pool.allocate(n); },
+            [&](void* p, std::size_t n) { pool.deallocate(p, n); });
+        const double malloc_ns = run(
+            num_threads, [](std::size_t n) { return std::malloc(n); },
+            [](void* p, std::size_t) { std::free(p); });
+        std::cout << num_threads
+                  << " thread(s): concurrent_memory_pool " << pool_ns
+                  << "ns/op, malloc " << malloc_ns << "ns/op" << std::endl;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Test allocator forwarding to std::allocator and counting what goes through
+// it. Rebound copies share the counts.
+struct allocation_counts {
+    std::atomic<std::size_t> allocations = 0;
+    std::atomic<std::size_t> deallocations = 0;
+    std::atomic<std::size_t> bytes = 0;
+    std::atomic<std::size_t> live_bytes = 0;
+};
+
+template <typename T>
+class counting_allocator {
+   public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator(allocation_counts& counts) : counts_(&counts) {}
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>& other)
+        : counts_(&other.counts()) {}
+
+    T* allocate(std::size_t n) {
+        ++counts_->allocations;
+        counts_->bytes += n * sizeof(T);
+        counts_->live_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        ++counts_->deallocations;
+        counts_->live_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    allocation_counts& counts() const { return *counts_; }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>& other) const {
+        return counts_ == &other.counts();
+    }
+
+   private:
+    allocation_counts* counts_;
+};
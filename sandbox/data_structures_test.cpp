@@ -1,10 +1,44 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "sandbox/counting_allocator.hpp"
+#include "src/data_structures/flat_hash_map.hpp"
+#include "src/data_structures/intrusive_list.hpp"
 #include "src/data_structures/linked_list.hpp"
+#include "src/data_structures/unrolled_list.hpp"
+#include "src/memory/arena.hpp"
 
 namespace {
 using int_list = kcu::linked_list<int>;
 using node = int_list::node;
 
+struct task : kcu::intrusive_list_hook {
+    explicit task(int id) : id(id) {}
+    int id;
+};
+
+struct cache_entry {
+    int key;
+    kcu::intrusive_list_hook lru_hook;
+    kcu::intrusive_list_hook shard_hook;
+};
+
+struct string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
 }  // namespace
 
 TEST(DataStructures, LinkedListConstruction) {
@@ -108,3 +142,573 @@ TEST(DataStructures, LinkedRemoveMiddle) {
     EXPECT_EQ(root->value(), 1);
     EXPECT_EQ(root->next()->value(), 3);
 }
+
+TEST(DataStructures, LinkedListPushAndIterate) {
+    kcu::linked_list<std::string> ll;
+    EXPECT_TRUE(ll.empty());
+    ll.push_back("b");
+    ll.push_front("a");
+    ll.emplace_back(3, 'c');
+    ll.emplace_front("z");
+
+    EXPECT_EQ(ll.size(), 4);
+    EXPECT_EQ(ll.front(), "z");
+    EXPECT_EQ(ll.back(), "ccc");
+    const std::vector<std::string> expected = {"z", "a", "b", "ccc"};
+    EXPECT_TRUE(
+        std::equal(ll.begin(), ll.end(), expected.begin(), expected.end()));
+
+    for (auto& s : ll) {
+        s += "!";
+    }
+    EXPECT_EQ(*std::find(ll.begin(), ll.end(), "b!"), "b!");
+    EXPECT_EQ(std::distance(ll.begin(), ll.end()), 4);
+}
+
+TEST(DataStructures, LinkedListInsertEraseAfter) {
+    int_list ll;
+    for (int i = 0; i < 10; ++i) {
+        ll.push_back(int(i));
+    }
+
+    // Single pass: drop the odd numbers, double the even ones
+    for (auto prev = ll.before_begin(), it = ll.begin(); it != ll.end();) {
+        if (*it % 2) {
+            it = ll.erase_after(prev);
+        } else {
+            it = ll.insert_after(it, *it * 10);
+            prev = it++;
+        }
+    }
+    const std::vector<int> expected = {0, 0, 2, 20, 4, 40, 6, 60, 8, 80};
+    EXPECT_TRUE(
+        std::equal(ll.begin(), ll.end(), expected.begin(), expected.end()));
+    EXPECT_EQ(ll.size(), expected.size());
+    EXPECT_EQ(ll.back(), 80);
+
+    // Erasing the last element moves the tail back
+    auto it = ll.begin();
+    std::advance(it, 8);
+    EXPECT_EQ(ll.erase_after(it), ll.end());
+    EXPECT_EQ(ll.back(), 8);
+    ll.push_back(9);
+    EXPECT_EQ(ll.back(), 9);
+
+    while (! ll.empty()) {
+        ll.erase_after(ll.before_begin());
+    }
+    ll.push_back(1);
+    EXPECT_EQ(ll.front(), 1);
+    EXPECT_EQ(ll.back(), 1);
+}
+
+TEST(DataStructures, LinkedListEraseStatefulAllocator) {
+    // Owning pointers carry a copy of the allocator, which must stay alive
+    // while the next node is relinked
+    allocation_counts counts;
+    {
+        kcu::linked_list<int, counting_allocator<int>> ll(counts);
+        for (int i = 0; i < 10; ++i) {
+            ll.push_back(int(i));
+        }
+        EXPECT_EQ(*ll.erase_after(ll.before_begin()), 1);
+        EXPECT_EQ(*ll.erase_after(ll.begin()), 3);
+        ll.remove(0);
+        ll.remove(2);
+        EXPECT_EQ(ll.size(), 6);
+        const std::vector<int> expected = {3, 4, 6, 7, 8, 9};
+        EXPECT_TRUE(
+            std::equal(ll.begin(), ll.end(), expected.begin(), expected.end()));
+        EXPECT_EQ(counts.deallocations, 4);
+    }
+    EXPECT_EQ(counts.allocations, 10);
+    EXPECT_EQ(counts.deallocations, 10);
+    EXPECT_EQ(counts.live_bytes, 0);
+}
+
+TEST(DataStructures, LinkedListSplice) {
+    int_list a;
+    int_list b;
+    for (int i = 0; i < 3; ++i) {
+        a.push_back(int(i));
+        b.push_back(int(10 + i));
+    }
+
+    a.splice_after(a.begin(), b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(b.begin(), b.end());
+    const std::vector<int> expected = {0, 10, 11, 12, 1, 2};
+    EXPECT_TRUE(
+        std::equal(a.begin(), a.end(), expected.begin(), expected.end()));
+    EXPECT_EQ(a.size(), 6);
+
+    // Splicing at the end moves the tail
+    b.push_back(20);
+    b.push_back(21);
+    auto last = a.begin();
+    std::advance(last, 5);
+    a.splice_after(last, b);
+    EXPECT_EQ(a.back(), 21);
+    EXPECT_EQ(a.size(), 8);
+
+    int_list c;
+    c.splice_after(c.before_begin(), a);
+    EXPECT_EQ(c.size(), 8);
+    EXPECT_EQ(c.front(), 0);
+    EXPECT_EQ(c.back(), 21);
+    b.push_back(1);
+    EXPECT_EQ(b.front(), 1);
+}
+
+TEST(DataStructures, LinkedListSizeWithPositions) {
+    int_list ll;
+    ll.insert(1, 0);
+    ll.insert(3, 1);
+    ll.insert(2, 1);
+    EXPECT_EQ(ll.size(), 3);
+    EXPECT_EQ(ll.back(), 3);
+    ll.remove(2);
+    EXPECT_EQ(ll.size(), 2);
+    EXPECT_EQ(ll.back(), 2);
+    EXPECT_THROW(ll.remove(2), std::runtime_error);
+    ll.remove(0);
+    ll.remove(0);
+    EXPECT_TRUE(ll.empty());
+    EXPECT_THROW(ll.remove(0), std::runtime_error);
+    EXPECT_THROW(ll.remove(1), std::runtime_error);
+    EXPECT_THROW(ll.insert(1, 1), std::runtime_error);
+
+    auto n2 = std::make_unique<node>(2, nullptr);
+    auto n1 = std::make_unique<node>(1, std::move(n2));
+    int_list from_nodes(std::move(n1));
+    EXPECT_EQ(from_nodes.size(), 2);
+    from_nodes.push_back(3);
+    EXPECT_EQ(std::accumulate(from_nodes.begin(), from_nodes.end(), 0), 6);
+}
+
+TEST(DataStructures, LinkedListBuildPerf) {
+    const auto time = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+
+    // push_back is O(1), appending by position walks the list every time
+    for (int n : {1000, 10000, 100000, 1000000}) {
+        int_list ll;
+        const double push_back_ns = time([&]() {
+            for (int i = 0; i < n; ++i) {
+                ll.push_back(int(i));
+            }
+        });
+        std::cout << "n = " << n << ": push_back " << push_back_ns / n
+                  << "ns/element";
+        if (n <= 10000) {
+            int_list by_position;
+            const double insert_ns = time([&]() {
+                for (int i = 0; i < n; ++i) {
+                    by_position.insert(int(i), i);
+                }
+            });
+            std::cout << ", insert at end " << insert_ns / n << "ns/element";
+        }
+        std::cout << std::endl;
+        EXPECT_EQ(ll.size(), n);
+    }
+}
+
+TEST(DataStructures, LinkedListLongDestruction) {
+    // Recursive destruction through the node_ptrs would overflow the stack
+    int_list ll;
+    for (int i = 0; i < 1 << 22; ++i) {
+        ll.insert(int(i), 0);
+    }
+}
+
+TEST(DataStructures, LinkedListArenaDestruction) {
+    kcu::arena arena;
+    {
+        kcu::linked_list<int, kcu::arena_allocator<int>> ll(arena);
+        for (int i = 0; i < 1 << 16; ++i) {
+            ll.push_front(int(i));
+        }
+        ll.clear();
+        EXPECT_TRUE(ll.empty());
+        for (int i = 0; i < 1 << 16; ++i) {
+            ll.push_back(int(i));
+        }
+        EXPECT_EQ(ll.back(), (1 << 16) - 1);
+    }
+}
+
+TEST(DataStructures, UnrolledListPushBack) {
+    kcu::unrolled_list<std::string, 4> ul;
+    for (int i = 0; i < 10; ++i) {
+        ul.push_back(std::to_string(i));
+    }
+    EXPECT_EQ(ul.size(), 10);
+    EXPECT_EQ(ul.front(), "0");
+    EXPECT_EQ(ul.back(), "9");
+
+    int i = 0;
+    for (const auto& s : ul) {
+        EXPECT_EQ(s, std::to_string(i++));
+    }
+    EXPECT_EQ(i, 10);
+}
+
+TEST(DataStructures, UnrolledListInsertRemove) {
+    kcu::unrolled_list<std::string, 4> ul;
+    std::vector<std::string> expected;
+    const auto check = [&]() {
+        EXPECT_EQ(ul.size(), expected.size());
+        EXPECT_TRUE(std::equal(ul.begin(), ul.end(), expected.begin(),
+                               expected.end()));
+    };
+
+    // Inserting into full nodes splits them
+    for (int i = 0; i < 20; ++i) {
+        const std::size_t pos = (i * 7) % (expected.size() + 1);
+        ul.insert(std::to_string(i), pos);
+        expected.insert(expected.begin() + pos, std::to_string(i));
+        check();
+    }
+    ul.push_front("front");
+    expected.insert(expected.begin(), "front");
+    check();
+
+    // Removing merges under-full nodes and unlinks empty ones
+    while (! expected.empty()) {
+        const std::size_t pos = (expected.size() * 5 + 3) % expected.size();
+        ul.remove(pos);
+        expected.erase(expected.begin() + pos);
+        check();
+    }
+    EXPECT_TRUE(ul.empty());
+    EXPECT_EQ(ul.begin(), ul.end());
+
+    ul.push_back("again");
+    EXPECT_EQ(ul.front(), "again");
+    EXPECT_EQ(ul.back(), "again");
+}
+
+TEST(DataStructures, UnrolledListOutOfRange) {
+    kcu::unrolled_list<int> ul;
+    EXPECT_THROW(ul.remove(0), std::runtime_error);
+    ul.push_back(1);
+    EXPECT_THROW(ul.insert(2, 2), std::runtime_error);
+    EXPECT_THROW(ul.remove(1), std::runtime_error);
+}
+
+TEST(DataStructures, UnrolledListPerf) {
+    constexpr int num_elements = 1000000;
+
+    const auto time = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+
+    long sum = 0;
+    const auto traverse_list = [&sum](const auto& ll) {
+        for (auto* n = ll.root().get(); n; n = n->next().get()) {
+            sum += n->value();
+        }
+    };
+    const auto traverse = [&sum](const auto& c) {
+        for (const int x : c) {
+            sum += x;
+        }
+    };
+
+    auto ll = std::make_unique<int_list>();
+    const double ll_build = time([&]() {
+        for (int i = 0; i < num_elements; ++i) {
+            ll->insert(int(i), 0);
+        }
+    });
+    const double ll_traverse = time([&]() { traverse_list(*ll); });
+
+    kcu::arena arena;
+    auto arena_ll = std::make_unique<
+        kcu::linked_list<int, kcu::arena_allocator<int>>>(arena);
+    const double arena_build = time([&]() {
+        for (int i = 0; i < num_elements; ++i) {
+            arena_ll->insert(int(i), 0);
+        }
+    });
+    const double arena_traverse = time([&]() { traverse_list(*arena_ll); });
+
+    kcu::unrolled_list<int> ul;
+    const double ul_build = time([&]() {
+        for (int i = 0; i < num_elements; ++i) {
+            ul.push_back(int(i));
+        }
+    });
+    const double ul_traverse = time([&]() { traverse(ul); });
+
+    std::vector<int> v;
+    const double v_build = time([&]() {
+        for (int i = 0; i < num_elements; ++i) {
+            v.push_back(i);
+        }
+    });
+    const double v_traverse = time([&]() { traverse(v); });
+
+    EXPECT_EQ(sum, 4L * num_elements * (num_elements - 1) / 2);
+    std::cout << "build / traverse 10^6 ints (ms): linked_list " << ll_build
+              << " / " << ll_traverse << ", arena linked_list "
+              << arena_build << " / " << arena_traverse
+              << ", unrolled_list " << ul_build << " / " << ul_traverse
+              << ", std::vector " << v_build << " / " << v_traverse
+              << std::endl;
+}
+
+TEST(DataStructures, IntrusiveListBaseHook) {
+    // A move constructed hook takes over the list position, there is no
+    // move assignment to silently leave the source linked
+    using hook = kcu::intrusive_list_hook;
+    static_assert(std::is_nothrow_move_constructible_v<hook>);
+    static_assert(! std::is_move_assignable_v<hook>);
+
+    std::vector<task> tasks;
+    for (int i = 0; i < 5; ++i) {
+        tasks.emplace_back(i);
+    }
+
+    kcu::intrusive_list<task> queue;
+    for (auto& t : tasks) {
+        queue.push_back(t);
+    }
+    EXPECT_EQ(queue.size(), 5);
+    EXPECT_EQ(queue.front().id, 0);
+    EXPECT_EQ(queue.back().id, 4);
+
+    // O(1) unlink by reference
+    queue.erase(tasks[2]);
+    EXPECT_FALSE(tasks[2].is_linked());
+    queue.push_front(tasks[2]);
+    std::vector<int> ids;
+    for (const auto& t : queue) {
+        ids.push_back(t.id);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{2, 0, 1, 3, 4}));
+
+    queue.pop_front();
+    queue.pop_back();
+    EXPECT_EQ(queue.size(), 3);
+    EXPECT_EQ(queue.front().id, 0);
+    EXPECT_EQ(queue.back().id, 3);
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(std::none_of(tasks.begin(), tasks.end(),
+                             [](const task& t) { return t.is_linked(); }));
+}
+
+TEST(DataStructures, IntrusiveListMemberHooks) {
+    std::vector<cache_entry> entries(6);
+    for (int i = 0; i < 6; ++i) {
+        entries[i].key = i;
+    }
+
+    // Each entry sits in the LRU list and in its shard's list
+    kcu::intrusive_list<cache_entry, &cache_entry::lru_hook> lru;
+    std::array<kcu::intrusive_list<cache_entry, &cache_entry::shard_hook>, 2>
+        shards;
+    for (auto& e : entries) {
+        lru.push_back(e);
+        shards[e.key % 2].push_back(e);
+    }
+
+    lru.move_to_back(entries[1]);
+    EXPECT_EQ(lru.front().key, 0);
+    EXPECT_EQ(lru.back().key, 1);
+
+    // Evict the least recently used entry from both lists
+    auto& victim = lru.front();
+    lru.pop_front();
+    shards[victim.key % 2].erase(victim);
+    EXPECT_EQ(shards[0].size(), 2);
+    EXPECT_EQ(shards[1].size(), 3);
+
+    std::vector<int> keys;
+    for (auto it = shards[0].begin(); it != shards[0].end(); ++it) {
+        keys.push_back(it->key);
+    }
+    EXPECT_EQ(keys, (std::vector<int>{2, 4}));
+    keys.clear();
+    for (auto it = lru.end(); it != lru.begin();) {
+        keys.push_back((--it)->key);
+    }
+    EXPECT_EQ(keys, (std::vector<int>{1, 5, 4, 3, 2}));
+
+    auto it = shards[1].insert(shards[1].iterator_to(entries[3]), entries[0]);
+    EXPECT_EQ(it->key, 0);
+    EXPECT_EQ((++it)->key, 3);
+}
+
+TEST(DataStructures, FlatHashMapInsertFindErase) {
+    kcu::flat_hash_map<int, int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(1), map.end());
+
+    constexpr int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        EXPECT_TRUE(map.try_emplace(i, i * 2).second);
+    }
+    EXPECT_FALSE(map.try_emplace(5, 0).second);
+    EXPECT_EQ(map.size(), n);
+    EXPECT_LE(map.load_factor(), 0.875f);
+    for (int i = 0; i < n; ++i) {
+        ASSERT_TRUE(map.contains(i));
+        EXPECT_EQ(map.at(i), i * 2);
+    }
+    EXPECT_FALSE(map.contains(n));
+    EXPECT_THROW(map.at(n), std::out_of_range);
+
+    for (int i = 0; i < n; i += 2) {
+        EXPECT_EQ(map.erase(i), 1);
+    }
+    EXPECT_EQ(map.erase(0), 0);
+    EXPECT_EQ(map.size(), n / 2);
+
+    long sum = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(key % 2, 1);
+        sum += value;
+    }
+    EXPECT_EQ(sum, 2 * (n / 2) * (n / 2));
+
+    for (auto it = map.begin(); it != map.end();) {
+        it = it->first < n / 2 ? map.erase(it) : std::next(it);
+    }
+    EXPECT_EQ(map.size(), n / 4);
+
+    map[-1] = 7;
+    ++map[-1];
+    EXPECT_EQ(map.at(-1), 8);
+
+    auto copy = map;
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(copy.size(), n / 4 + 1);
+    EXPECT_EQ(copy.at(n - 1), 2 * (n - 1));
+}
+
+TEST(DataStructures, FlatHashMapTombstones) {
+    // Churn through keys at a constant size, erased slots must be reused or
+    // reclaimed rather than grow the table
+    kcu::flat_hash_map<int, int> map;
+    map.reserve(100);
+    const auto capacity = map.capacity();
+    for (int i = 0; i < 100000; ++i) {
+        map.try_emplace(i, i);
+        if (i >= 50) {
+            ASSERT_EQ(map.erase(i - 50), 1);
+        }
+    }
+    EXPECT_EQ(map.size(), 50);
+    EXPECT_EQ(map.capacity(), capacity);
+    for (int i = 100000 - 50; i < 100000; ++i) {
+        EXPECT_TRUE(map.contains(i));
+    }
+}
+
+TEST(DataStructures, FlatHashMapHeterogeneousLookup) {
+    kcu::flat_hash_map<std::string, int, string_hash, std::equal_to<>> map;
+    map.try_emplace("one", 1);
+    map.try_emplace("two", 2);
+
+    // No std::string is constructed for the lookups
+    const std::string_view key = "two";
+    EXPECT_EQ(map.find(key)->second, 2);
+    EXPECT_TRUE(map.contains("one"));
+    EXPECT_EQ(map.count(std::string_view("three")), 0);
+    EXPECT_EQ(map.erase(key), 1);
+    EXPECT_EQ(map.size(), 1);
+}
+
+TEST(DataStructures, FlatHashMapCustomAllocator) {
+    allocation_counts counts;
+    {
+        using allocator = counting_allocator<std::pair<const int, int>>;
+        kcu::flat_hash_map<int, int, std::hash<int>, std::equal_to<int>,
+                           allocator>
+            map{allocator(counts)};
+        map.reserve(1000);
+        const auto allocations = counts.allocations.load();
+        for (int i = 0; i < 1000; ++i) {
+            map.try_emplace(i, i);
+        }
+        // Slots and control bytes, and nothing per element
+        EXPECT_EQ(allocations, 2);
+        EXPECT_EQ(counts.allocations, allocations);
+    }
+    EXPECT_EQ(counts.deallocations, counts.allocations);
+    EXPECT_EQ(counts.live_bytes, 0);
+}
+
+TEST(DataStructures, FlatHashMapRelocatesHookedValues) {
+    // Growing the table moves the values, their hooks keep the list intact
+    kcu::flat_hash_map<int, cache_entry> map;
+    kcu::intrusive_list<cache_entry, &cache_entry::lru_hook> lru;
+    for (int i = 0; i < 1000; ++i) {
+        auto& e = map[i];
+        e.key = i;
+        lru.push_back(e);
+    }
+    EXPECT_EQ(lru.size(), 1000);
+    int expected = 0;
+    for (const auto& e : lru) {
+        EXPECT_EQ(e.key, expected++);
+        EXPECT_EQ(&e, &map.at(e.key));
+    }
+}
+
+TEST(DataStructures, FlatHashMapPerf) {
+    const auto time = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+
+    // Scattered keys, looked up in random order so that nodes allocated in
+    // insertion order are not visited sequentially
+    const auto key = [](std::uint64_t i) { return i * 0x9e3779b97f4a7c15ull; };
+    const auto run = [&](auto& map, std::uint64_t n) {
+        const double insert_ns = time([&]() {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                map.try_emplace(key(i), i);
+            }
+        });
+        std::vector<std::uint64_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(42));
+        std::uint64_t sum = 0;
+        const double find_ns = time([&]() {
+            for (const auto i : order) {
+                sum += map.find(key(i))->second;
+            }
+        });
+        EXPECT_EQ(sum, n * (n - 1) / 2);
+        return std::pair{insert_ns / n, find_ns / n};
+    };
+
+    for (std::uint64_t n : {1000, 10000, 100000, 1000000, 10000000}) {
+        kcu::flat_hash_map<std::uint64_t, std::uint64_t> flat;
+        const auto [flat_insert, flat_find] = run(flat, n);
+        std::unordered_map<std::uint64_t, std::uint64_t> node_based;
+        const auto [node_insert, node_find] = run(node_based, n);
+        std::cout << "n = " << n << ": flat_hash_map insert " << flat_insert
+                  << "ns, find " << flat_find
+                  << "ns; std::unordered_map insert " << node_insert
+                  << "ns, find " << node_find << "ns" << std::endl;
+    }
+}
@@ -0,0 +1,131 @@
+#include "src/profiling/hdr_histogram.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+TEST(HdrHistogram, Empty) {
+    kcu::hdr_histogram h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.p99(), 0u);
+    EXPECT_EQ(h.mean(), 0.0);
+}
+
+TEST(HdrHistogram, BucketsCoverValuesWithBoundedError) {
+    std::mt19937_64 rng(42);
+    std::vector<std::uint64_t> values = {0, 1, 255, 256, 257, 1000,
+                                         UINT64_MAX};
+    for (int i = 0; i < 100000; ++i) {
+        values.push_back(rng() >> (rng() % 64));
+    }
+    for (const auto v : values) {
+        const auto bucket = kcu::hdr_histogram::bucket_of(v);
+        ASSERT_LT(bucket, kcu::hdr_histogram::bucket_count);
+        const auto lowest = kcu::hdr_histogram::lowest_in_bucket(bucket);
+        const auto highest = kcu::hdr_histogram::highest_in_bucket(bucket);
+        ASSERT_LE(lowest, v);
+        ASSERT_GE(highest, v);
+        // Width at most 1/128 of the values counted
+        ASSERT_LE(highest - lowest, lowest / 128);
+    }
+    // Consecutive buckets are adjacent
+    for (std::size_t b = 1; b < kcu::hdr_histogram::bucket_count; ++b) {
+        ASSERT_EQ(kcu::hdr_histogram::lowest_in_bucket(b),
+                  kcu::hdr_histogram::highest_in_bucket(b - 1) + 1);
+    }
+    EXPECT_EQ(kcu::hdr_histogram::highest_in_bucket(
+                  kcu::hdr_histogram::bucket_count - 1),
+              UINT64_MAX);
+}
+
+TEST(HdrHistogram, Percentiles) {
+    kcu::hdr_histogram h;
+    for (std::uint64_t v = 1; v <= 100000; ++v) {
+        h.record(v);
+    }
+    EXPECT_EQ(h.count(), 100000u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 100000u);
+    EXPECT_DOUBLE_EQ(h.mean(), 50000.5);
+    EXPECT_NEAR(double(h.p50()), 50000.0, 50000.0 / 128);
+    EXPECT_NEAR(double(h.p99()), 99000.0, 99000.0 / 128);
+    EXPECT_NEAR(double(h.p999()), 99900.0, 99900.0 / 128);
+    EXPECT_EQ(h.value_at_percentile(100.0), 100000u);
+    EXPECT_EQ(h.value_at_percentile(0.0), 1u);
+}
+
+TEST(HdrHistogram, TailOfSkewedDistribution) {
+    kcu::hdr_histogram h;
+    h.record(100, 9990);
+    for (int i = 0; i < 10; ++i) {
+        h.record(std::chrono::milliseconds(1));
+    }
+    // The average hides the tail the percentiles show
+    EXPECT_LT(h.mean(), 1100.0);
+    EXPECT_EQ(h.p50(), 100u);
+    EXPECT_EQ(h.p99(), 100u);
+    EXPECT_NEAR(double(h.value_at_percentile(99.95)), 1e6, 1e6 / 128);
+    EXPECT_EQ(h.max(), 1000000u);
+}
+
+TEST(HdrHistogram, MergeAndReset) {
+    kcu::hdr_histogram a;
+    kcu::hdr_histogram b;
+    a.record(10, 3);
+    b.record(1000);
+    a += b;
+    EXPECT_EQ(a.count(), 4u);
+    EXPECT_EQ(a.min(), 10u);
+    EXPECT_EQ(a.max(), 1000u);
+    EXPECT_EQ(b.count(), 1u);
+
+    kcu::hdr_histogram c = a;
+    a.reset();
+    EXPECT_EQ(a.count(), 0u);
+    EXPECT_EQ(a.max(), 0u);
+    EXPECT_EQ(c.count(), 4u);
+    EXPECT_EQ(c.p50(), 10u);
+}
+
+TEST(HdrHistogram, ConcurrentRecording) {
+    constexpr int threads = 4;
+    constexpr int n = 100000;
+    kcu::hdr_histogram h;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&h, t]() {
+            for (int i = 0; i < n; ++i) {
+                h.record(std::uint64_t(t) * n + i);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    EXPECT_EQ(h.count(), std::uint64_t(threads) * n);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), std::uint64_t(threads) * n - 1);
+}
+
+TEST(HdrHistogram, Perf) {
+    constexpr int n = 10000000;
+    kcu::hdr_histogram h;
+    std::mt19937_64 rng(1);
+    std::vector<std::uint64_t> values(1 << 16);
+    for (auto& v : values) {
+        v = rng() % 1000000;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        h.record(values[i & (values.size() - 1)]);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "hdr_histogram::record: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() / n
+              << " ns, p99 " << h.p99() << std::endl;
+}
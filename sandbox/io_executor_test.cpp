@@ -0,0 +1,199 @@
+#include "src/io/io_executor.hpp"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+constexpr kcu::io_backend backends[] = {kcu::io_backend::io_uring,
+                                        kcu::io_backend::thread_pool};
+
+// Temporary file, removed when done
+class temp_file {
+   public:
+    explicit temp_file(const std::string& name)
+        : path_(std::filesystem::temp_directory_path() / ("kcu_" + name)) {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::system_category(), "open");
+        }
+    }
+
+    ~temp_file() {
+        ::close(fd_);
+        std::filesystem::remove(path_);
+    }
+
+    int fd() const { return fd_; }
+
+   private:
+    std::filesystem::path path_;
+    int fd_;
+};
+
+std::vector<std::byte> pattern(std::size_t size, unsigned seed) {
+    std::vector<std::byte> bytes(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        bytes[i] = std::byte((i * 31 + seed) & 0xff);
+    }
+    return bytes;
+}
+
+}  // namespace
+
+TEST(IoExecutor, WritesReadsAndSyncs) {
+    for (auto backend : backends) {
+        kcu::io_executor io(backend);
+        temp_file file("io_rw");
+        const auto data = pattern(8192, 7);
+
+        EXPECT_EQ(io.async_write(file.fd(), data, 0).get(), data.size());
+        io.fsync(file.fd()).get();
+        io.fsync(file.fd(), true).get();
+
+        std::vector<std::byte> back(4096);
+        EXPECT_EQ(io.async_read(file.fd(), back, 4096).get(), back.size());
+        EXPECT_TRUE(std::equal(back.begin(), back.end(), data.begin() + 4096));
+
+        // Short read at the end of the file, then none past it
+        EXPECT_EQ(io.async_read(file.fd(), back, 6144).get(), 2048u);
+        EXPECT_EQ(io.async_read(file.fd(), back, 8192).get(), 0u);
+    }
+}
+
+TEST(IoExecutor, FallsBackToThreadPool) {
+    kcu::io_executor io(kcu::io_backend::thread_pool);
+    EXPECT_EQ(io.backend(), kcu::io_backend::thread_pool);
+}
+
+TEST(IoExecutor, ThrowsErrorsFromGet) {
+    for (auto backend : backends) {
+        kcu::io_executor io(backend);
+        std::vector<std::byte> buf(16);
+        auto f = io.async_read(-1, buf, 0);
+        try {
+            f.get();
+            FAIL() << "expected an error";
+        } catch (const std::system_error& e) {
+            EXPECT_EQ(e.code().value(), EBADF);
+        }
+    }
+}
+
+TEST(IoExecutor, ChainsContinuations) {
+    for (auto backend : backends) {
+        kcu::io_executor io(backend);
+        temp_file file("io_then");
+        const auto data = pattern(100, 3);
+        const auto n = io.async_write(file.fd(), data, 0)
+                           .then([](std::size_t written) {
+                               return written * 2;
+                           })
+                           .get();
+        EXPECT_EQ(n, 200u);
+    }
+}
+
+TEST(IoExecutor, ReadsAndWritesRegisteredBuffers) {
+    for (auto backend : backends) {
+        kcu::io_executor io(backend);
+        temp_file file("io_fixed");
+        std::vector<std::byte> out = pattern(4096, 11);
+        std::vector<std::byte> in(8192);
+        io.register_buffers({out, in});
+
+        EXPECT_EQ(io.async_write_fixed(file.fd(), out, 0, 0).get(), 4096u);
+        // Into the second half of the second buffer
+        const std::span<std::byte> half(in.data() + 4096, 4096);
+        EXPECT_EQ(io.async_read_fixed(file.fd(), half, 0, 1).get(), 4096u);
+        EXPECT_TRUE(std::equal(out.begin(), out.end(), half.begin()));
+
+        // Not within the named buffer
+        EXPECT_THROW(io.async_read_fixed(file.fd(), in, 0, 0),
+                     std::invalid_argument);
+        EXPECT_THROW(io.async_read_fixed(file.fd(), in, 0, 2),
+                     std::invalid_argument);
+
+        io.unregister_buffers();
+        EXPECT_THROW(io.async_read_fixed(file.fd(), half, 0, 1),
+                     std::invalid_argument);
+    }
+}
+
+TEST(IoExecutor, LimitsRequestsInFlight) {
+    for (auto backend : backends) {
+        constexpr std::size_t blocks = 256;
+        temp_file file("io_depth");
+        std::vector<std::byte> data(blocks * 64);
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            data[i] = std::byte(i / 64);
+        }
+        ASSERT_EQ(::pwrite(file.fd(), data.data(), data.size(), 0),
+                  ssize_t(data.size()));
+
+        // More reads than the queue depth, submission waits for room
+        kcu::io_executor io(backend, 8);
+        std::vector<std::vector<std::byte>> bufs(
+            blocks, std::vector<std::byte>(64));
+        std::vector<kcu::future<std::size_t>> reads;
+        for (std::size_t i = 0; i < blocks; ++i) {
+            reads.push_back(io.async_read(file.fd(), bufs[i], i * 64));
+        }
+        for (std::size_t i = 0; i < blocks; ++i) {
+            EXPECT_EQ(reads[i].get(), 64u);
+            EXPECT_EQ(bufs[i][63], std::byte(i));
+        }
+    }
+}
+
+TEST(IoExecutor, Perf) {
+    constexpr std::size_t block = 4096;
+    constexpr std::size_t blocks = 4096;
+    constexpr std::size_t depth = 32;
+    constexpr std::size_t reads = 65536;
+    temp_file file("io_perf");
+    const auto data = pattern(block * blocks, 5);
+    ASSERT_EQ(::pwrite(file.fd(), data.data(), data.size(), 0),
+              ssize_t(data.size()));
+
+    // Random 4K reads of a cached file, depth reads in flight at a time
+    const auto iops = [&](kcu::io_backend backend) {
+        kcu::io_executor io(backend, depth);
+        std::vector<std::byte> bufs(block * depth);
+        std::mt19937_64 rng(42);
+        std::vector<kcu::future<std::size_t>> batch;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t done = 0; done < reads; done += depth) {
+            for (std::size_t i = 0; i < depth; ++i) {
+                const std::span<std::byte> buf(bufs.data() + i * block,
+                                               block);
+                batch.push_back(io.async_read(file.fd(), buf,
+                                              rng() % blocks * block));
+            }
+            for (auto& f : batch) {
+                EXPECT_EQ(f.get(), block);
+            }
+            batch.clear();
+        }
+        return reads / std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    };
+
+    const double uring = iops(kcu::io_backend::io_uring);
+    const double pool = iops(kcu::io_backend::thread_pool);
+    std::cout << "Random 4K reads, " << depth
+              << " in flight: io_uring: " << uring
+              << " IOPS, pread on a thread pool: " << pool << " IOPS"
+              << std::endl;
+}
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "src/concurrency/epoch_reclamation.hpp"
+#include "src/concurrency/lock_free_list.hpp"
+#include "src/concurrency/treiber_stack.hpp"
+#include "src/data_structures/linked_list.hpp"
+
+using namespace kcu;
+
+namespace {
+
+struct counted {
+    static inline std::atomic<int> destroyed = 0;
+    ~counted() { ++destroyed; }
+};
+
+// Sorted set over linked_list behind a mutex, the baseline for lock_free_list
+class locked_list_set {
+   public:
+    bool insert(int value) {
+        std::scoped_lock lock(mtx_);
+        auto [prev, curr] = find(value);
+        if (curr != list_.end() && *curr == value) {
+            return false;
+        }
+        list_.insert_after(prev, int(value));
+        return true;
+    }
+
+    bool erase(int value) {
+        std::scoped_lock lock(mtx_);
+        auto [prev, curr] = find(value);
+        if (curr == list_.end() || *curr != value) {
+            return false;
+        }
+        list_.erase_after(prev);
+        return true;
+    }
+
+    bool contains(int value) {
+        std::scoped_lock lock(mtx_);
+        auto curr = find(value).second;
+        return curr != list_.end() && *curr == value;
+    }
+
+   private:
+    using iterator = linked_list<int>::iterator;
+
+    std::pair<iterator, iterator> find(int value) {
+        auto prev = list_.before_begin();
+        auto curr = list_.begin();
+        while (curr != list_.end() && *curr < value) {
+            prev = curr++;
+        }
+        return {prev, curr};
+    }
+
+    std::mutex mtx_;
+    linked_list<int> list_;
+};
+
+}  // namespace
+
+TEST(EpochReclamation, DefersWhilePinned) {
+    epoch_domain domain;
+    counted::destroyed = 0;
+
+    std::promise<void> pinned;
+    std::promise<void> release;
+    std::thread reader([&]() {
+        epoch_domain::guard guard(domain);
+        pinned.set_value();
+        release.get_future().wait();
+    });
+    pinned.get_future().wait();
+
+    for (int i = 0; i < 100; ++i) {
+        domain.retire(new counted);
+    }
+    for (int i = 0; i < 4; ++i) {
+        domain.collect();
+    }
+    // The reader may still reference them
+    EXPECT_EQ(counted::destroyed, 0);
+
+    release.set_value();
+    reader.join();
+    for (int i = 0; i < 4; ++i) {
+        domain.collect();
+    }
+    EXPECT_EQ(counted::destroyed, 100);
+}
+
+TEST(EpochReclamation, FreesOnDestruction) {
+    counted::destroyed = 0;
+    {
+        epoch_domain domain;
+        epoch_domain::guard guard(domain);
+        for (int i = 0; i < 10; ++i) {
+            domain.retire(new counted);
+        }
+    }
+    EXPECT_EQ(counted::destroyed, 10);
+}
+
+TEST(TreiberStack, Basic) {
+    treiber_stack<std::string> stack;
+    EXPECT_TRUE(stack.empty());
+    EXPECT_FALSE(stack.pop());
+    stack.push("a");
+    stack.emplace(2, 'b');
+    EXPECT_EQ(stack.pop(), "bb");
+    EXPECT_EQ(stack.pop(), "a");
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(TreiberStack, Stress) {
+    constexpr int num_threads = 4;
+    constexpr int num_values = 20000;
+    treiber_stack<int> stack;
+    std::vector<std::atomic<int>> popped(num_threads * num_values);
+    std::atomic<int> remaining = num_threads * num_values;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num_values; ++i) {
+                stack.push(t * num_values + i);
+            }
+        });
+        threads.emplace_back([&]() {
+            while (remaining > 0) {
+                if (auto value = stack.pop()) {
+                    ++popped[*value];
+                    --remaining;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(stack.empty());
+    EXPECT_TRUE(std::all_of(popped.begin(), popped.end(),
+                            [](const auto& n) { return n == 1; }));
+}
+
+TEST(LockFreeList, Basic) {
+    lock_free_list<int> list;
+    EXPECT_TRUE(list.insert(3));
+    EXPECT_TRUE(list.insert(1));
+    EXPECT_TRUE(list.insert(2));
+    EXPECT_FALSE(list.insert(2));
+    EXPECT_TRUE(list.contains(1));
+    EXPECT_FALSE(list.contains(4));
+
+    EXPECT_TRUE(list.erase(2));
+    EXPECT_FALSE(list.erase(2));
+    EXPECT_FALSE(list.contains(2));
+
+    std::vector<int> values;
+    list.for_each([&](int v) { values.push_back(v); });
+    EXPECT_EQ(values, (std::vector<int>{1, 3}));
+}
+
+TEST(LockFreeList, Stress) {
+    constexpr int num_threads = 4;
+    constexpr int num_values = 2000;
+    lock_free_list<int> list;
+
+    // Each thread inserts its own range, then erases the even values of
+    // its neighbour's range, while looking up values in between
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num_values; ++i) {
+                EXPECT_TRUE(list.insert(t * num_values + i));
+            }
+            const int neighbour = (t + 1) % num_threads;
+            for (int i = 0; i < num_values; i += 2) {
+                list.contains(neighbour * num_values + i + 1);
+                while (! list.erase(neighbour * num_values + i)) {
+                    // Not inserted yet
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::vector<int> values;
+    list.for_each([&](int v) { values.push_back(v); });
+    ASSERT_EQ(values.size(), num_threads * num_values / 2);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(values[i], 2 * i + 1);
+    }
+}
+
+TEST(LockFreeList, Perf) {
+    static constexpr int num_threads = 4;
+    static constexpr int num_ops = 100000;
+    static constexpr int key_range = 512;
+
+    // 80% lookups, 10% inserts, 10% erases
+    const auto run = [&](auto& set) {
+        for (int i = 0; i < key_range; i += 2) {
+            set.insert(i);
+        }
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&set, t]() {
+                std::mt19937 rng(t);
+                std::uniform_int_distribution<int> key(0, key_range - 1);
+                std::uniform_int_distribution<int> op(0, 9);
+                for (int i = 0; i < num_ops; ++i) {
+                    const int k = key(rng);
+                    switch (op(rng)) {
+                        case 0:
+                            set.insert(k);
+                            break;
+                        case 1:
+                            set.erase(k);
+                            break;
+                        default:
+                            set.contains(k);
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return num_threads * num_ops / elapsed.count() / 1e6;
+    };
+
+    lock_free_list<int> lock_free;
+    locked_list_set locked;
+    const double lock_free_mops = run(lock_free);
+    const double locked_mops = run(locked);
+    std::cout << "lock_free_list: " << lock_free_mops
+              << " Mops/s, mutex guarded linked_list: " << locked_mops
+              << " Mops/s" << std::endl;
+}
@@ -0,0 +1,193 @@
+#include "src/concurrency/multicast_ring.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "src/concurrency/spsc_queue.hpp"
+
+TEST(MulticastRing, EveryConsumerSeesEveryValue) {
+    kcu::multicast_ring<int> ring(4);
+    auto& a = ring.add_consumer();
+    auto& b = ring.add_consumer();
+    for (int i = 0; i < 3; ++i) {
+        ring.publish(i);
+    }
+    std::vector<int> seen_a;
+    std::vector<int> seen_b;
+    EXPECT_EQ(a.poll([&](const int& v) { seen_a.push_back(v); }), 3u);
+    EXPECT_EQ(b.poll([&](const int& v) { seen_b.push_back(v); }), 3u);
+    EXPECT_EQ(seen_a, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(seen_b, seen_a);
+    EXPECT_EQ(a.poll([](const int&) {}), 0u);
+    EXPECT_EQ(a.sequence(), 3u);
+}
+
+TEST(MulticastRing, SlowestConsumerGatesProducer) {
+    kcu::multicast_ring<int> ring(3);
+    EXPECT_EQ(ring.capacity(), 4u);
+    auto& fast = ring.add_consumer();
+    auto& slow = ring.add_consumer();
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.try_publish(i));
+        fast.poll([](const int&) {});
+    }
+    EXPECT_FALSE(ring.try_publish(4));
+    // Freeing one slot lets one more value in
+    EXPECT_EQ(slow.poll([](const int& v) { EXPECT_EQ(v, 0); }, 1), 1u);
+    EXPECT_TRUE(ring.try_publish(4));
+    EXPECT_FALSE(ring.try_publish(5));
+    std::vector<int> rest;
+    slow.poll([&](const int& v) { rest.push_back(v); });
+    EXPECT_EQ(rest, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST(MulticastRing, BatchReads) {
+    kcu::multicast_ring<int> ring(16);
+    auto& c = ring.add_consumer();
+    for (int i = 0; i < 10; ++i) {
+        ring.publish(i);
+    }
+    EXPECT_EQ(c.available(), 10u);
+    int sum = 0;
+    EXPECT_EQ(c.poll([&](const int& v) { sum += v; }, 4), 4u);
+    EXPECT_EQ(sum, 0 + 1 + 2 + 3);
+    EXPECT_EQ(c.available(), 6u);
+}
+
+TEST(MulticastRing, DependentConsumerFollows) {
+    kcu::multicast_ring<int> ring(8);
+    auto& first = ring.add_consumer();
+    auto& second = ring.add_consumer({&first});
+    ring.publish(1);
+    ring.publish(2);
+    EXPECT_EQ(second.available(), 0u);
+    first.poll([](const int&) {}, 1);
+    EXPECT_EQ(second.available(), 1u);
+
+    kcu::multicast_ring<int> other(8);
+    EXPECT_THROW(other.add_consumer({&first}), std::invalid_argument);
+}
+
+TEST(MulticastRing, ConcurrentPipeline) {
+    constexpr std::uint64_t n = 200000;
+    kcu::multicast_ring<std::uint64_t> ring(64);
+    // risk checks each value, strategy reads it only after risk did
+    std::vector<std::uint8_t> checked(n, 0);
+    auto& logger = ring.add_consumer();
+    auto& risk = ring.add_consumer();
+    auto& strategy = ring.add_consumer({&risk});
+
+    std::atomic<bool> ok = true;
+    auto consume = [&](kcu::multicast_ring<std::uint64_t>::consumer& c,
+                       auto on_value) {
+        return std::thread([&c, on_value, &ok]() mutable {
+            std::uint64_t expected = 0;
+            while (expected < n) {
+                c.poll([&](const std::uint64_t& v) {
+                    if (v != expected++) {
+                        ok = false;
+                    }
+                    on_value(v);
+                });
+                std::this_thread::yield();
+            }
+        });
+    };
+    std::vector<std::thread> threads;
+    threads.push_back(consume(logger, [](std::uint64_t) {}));
+    threads.push_back(consume(risk, [&](std::uint64_t v) { checked[v] = 1; }));
+    threads.push_back(consume(strategy, [&](std::uint64_t v) {
+        if (! checked[v]) {
+            ok = false;
+        }
+    }));
+    for (std::uint64_t i = 0; i < n; ++i) {
+        ring.publish(i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(ring.cursor(), n);
+}
+
+// One producer fanning out to three consumers, through one multicast_ring or
+// one spsc_queue per consumer
+TEST(MulticastRing, Perf) {
+    constexpr int consumers = 3;
+    constexpr std::uint64_t n = 1000000;
+    constexpr std::size_t capacity = 1024;
+    const auto time = [](auto f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(
+                   std::chrono::steady_clock::now() - start)
+                   .count() /
+               n;
+    };
+
+    const double ring_ns = time([&]() {
+        kcu::multicast_ring<std::uint64_t> ring(capacity);
+        std::vector<std::thread> threads;
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&c = ring.add_consumer()]() {
+                std::uint64_t seen = 0;
+                std::uint64_t sum = 0;
+                while (seen < n) {
+                    const auto read = c.poll(
+                        [&](const std::uint64_t& v) { sum += v; });
+                    if (read == 0) {
+                        std::this_thread::yield();
+                    }
+                    seen += read;
+                }
+                EXPECT_EQ(sum, n * (n - 1) / 2);
+            });
+        }
+        for (std::uint64_t i = 0; i < n; ++i) {
+            ring.publish(i);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    });
+
+    const double queues_ns = time([&]() {
+        std::vector<std::unique_ptr<kcu::spsc_queue<std::uint64_t>>> queues;
+        std::vector<std::thread> threads;
+        for (int c = 0; c < consumers; ++c) {
+            queues.push_back(
+                std::make_unique<kcu::spsc_queue<std::uint64_t>>(capacity));
+            threads.emplace_back([&q = *queues.back()]() {
+                std::uint64_t sum = 0;
+                for (std::uint64_t seen = 0; seen < n; ++seen) {
+                    while (q.empty()) {
+                        std::this_thread::yield();
+                    }
+                    sum += *q.front();
+                    q.pop();
+                }
+                EXPECT_EQ(sum, n * (n - 1) / 2);
+            });
+        }
+        for (std::uint64_t i = 0; i < n; ++i) {
+            for (auto& q : queues) {
+                while (q->size() >= capacity) {
+                    std::this_thread::yield();
+                }
+                q->push(std::uint64_t(i));
+            }
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    });
+
+    std::cout << "Fan-out to " << consumers << " consumers: multicast_ring "
+              << ring_ns << " ns, " << consumers << " spsc_queues "
+              << queues_ns << " ns per message" << std::endl;
+}
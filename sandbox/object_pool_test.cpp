@@ -0,0 +1,180 @@
+#include "src/memory/object_pool.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "src/data_structures/linked_list.hpp"
+
+using namespace kcu;
+
+namespace {
+
+struct alignas(64) aligned_object {
+    int x = 0;
+};
+
+}  // namespace
+
+TEST(ObjectPool, CreateDestroy) {
+    object_pool<std::string> pool;
+
+    std::set<std::string*> addresses;
+    std::vector<std::string*> objects;
+    for (int i = 0; i < 10000; ++i) {
+        objects.push_back(pool.create(std::to_string(i)));
+        addresses.insert(objects.back());
+    }
+    EXPECT_EQ(addresses.size(), objects.size());
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(*objects[i], std::to_string(i));
+    }
+
+    for (auto* o : objects) {
+        pool.destroy(o);
+    }
+    // Freed slots are reused last in, first out
+    std::string* reused = pool.create("Reused");
+    EXPECT_EQ(reused, objects.back());
+    pool.destroy(reused);
+}
+
+TEST(ObjectPool, NoPerObjectHeader) {
+    struct object {
+        char bytes[24];
+    };
+    object_pool<object> pool;
+    auto* o1 = pool.allocate();
+    auto* o2 = pool.allocate();
+    EXPECT_EQ(reinterpret_cast<char*>(o2) - reinterpret_cast<char*>(o1),
+              sizeof(object));
+    pool.deallocate(o1);
+    pool.deallocate(o2);
+}
+
+TEST(ObjectPool, Alignment) {
+    object_pool<aligned_object> pool;
+    for (int i = 0; i < 100000; ++i) {
+        auto* o = pool.create();
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(o) % 64, 0);
+    }
+}
+
+TEST(ObjectPoolAllocator, StdContainers) {
+    object_pool_resource resource;
+
+    std::list<int, object_pool_allocator<int>> l(resource);
+    std::map<int, std::string, std::less<int>,
+             object_pool_allocator<std::pair<const int, std::string>>>
+        m(resource);
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        m.emplace(i, std::to_string(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        m.erase(i);
+    }
+    l.remove_if([](int i) { return i % 2 == 0; });
+
+    EXPECT_EQ(l.size(), 500);
+    EXPECT_EQ(m.size(), 500);
+    EXPECT_EQ(l.front(), 1);
+    EXPECT_EQ(m.begin()->second, "1");
+
+    // Rebound allocators share the resource
+    EXPECT_TRUE(l.get_allocator() == m.get_allocator());
+}
+
+TEST(ObjectPoolAllocator, LinkedList) {
+    object_pool_resource resource;
+    object_pool_allocator<int> alloc(resource);
+
+    linked_list<int, object_pool_allocator<int>> ll(alloc);
+    ll.insert(3, 0);
+    ll.insert(1, 0);
+    ll.insert(2, 1);
+    ll.remove(0);
+
+    const auto& root = ll.root();
+    EXPECT_EQ(root->value(), 2);
+    EXPECT_EQ(root->next()->value(), 3);
+}
+
+TEST(ObjectPoolAllocator, LinkedListEraseAndDestroy) {
+    object_pool_resource resource;
+    object_pool_allocator<int> alloc(resource);
+    {
+        // Destroyed at scope exit while the resource is still alive
+        linked_list<int, object_pool_allocator<int>> ll(alloc);
+        for (int i = 0; i < 100; ++i) {
+            ll.push_back(int(i));
+        }
+
+        // Erased nodes go back to the pool and are handed out again next
+        const int* erased = &*std::next(ll.begin());
+        ll.erase_after(ll.begin());
+        EXPECT_EQ(&ll.emplace_front(-1), erased);
+
+        ll.remove(0);
+        ll.remove(50);
+        ll.erase_after(ll.before_begin());
+        EXPECT_EQ(ll.size(), 97);
+        EXPECT_EQ(ll.front(), 2);
+        EXPECT_EQ(ll.back(), 99);
+    }
+}
+
+// Node insert / erase throughput against std::allocator
+TEST(ObjectPoolAllocator, Perf) {
+    constexpr int num_nodes = 1 << 16;
+    constexpr int rounds = 16;
+
+    const auto time = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            f();
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (rounds * num_nodes);
+    };
+    const auto list_churn = [](auto& l) {
+        return [&l]() {
+            for (int i = 0; i < num_nodes; ++i) {
+                l.push_back(i);
+            }
+            while (! l.empty()) {
+                l.pop_front();
+            }
+        };
+    };
+    const auto map_churn = [](auto& m) {
+        return [&m]() {
+            for (int i = 0; i < num_nodes; ++i) {
+                m.emplace(i, i);
+            }
+            for (int i = 0; i < num_nodes; ++i) {
+                m.erase(i);
+            }
+        };
+    };
+
+    object_pool_resource resource;
+    std::list<int> std_list;
+    std::list<int, object_pool_allocator<int>> pool_list(resource);
+    std::map<int, int> std_map;
+    std::map<int, int, std::less<int>,
+             object_pool_allocator<std::pair<const int, int>>>
+        pool_map(resource);
+
+    std::cout << "std::list: std::allocator " << time(list_churn(std_list))
+              << "ns/node, object_pool_allocator "
+              << time(list_churn(pool_list)) << "ns/node" << std::endl;
+    std::cout << "std::map: std::allocator " << time(map_churn(std_map))
+              << "ns/node, object_pool_allocator "
+              << time(map_churn(pool_map)) << "ns/node" << std::endl;
+}
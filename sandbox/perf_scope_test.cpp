@@ -0,0 +1,42 @@
+#include "src/profiling/perf_scope.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+TEST(PerfScope, CountsContextSwitches) {
+    kcu::perf_scope scope;
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto counts = scope.counts();
+    if (! counts.context_switches) {
+        GTEST_SKIP() << "perf_event_open not permitted";
+    }
+    // Each sleep blocks the thread at least once
+    EXPECT_GE(*counts.context_switches, 5);
+}
+
+TEST(PerfScope, CountsInstructions) {
+    kcu::perf_scope scope;
+    long sum = 0;
+    for (long i = 0; i < 1000000; ++i) {
+        sum += i;
+        asm volatile("" : "+r"(sum));
+    }
+    const auto counts = scope.counts();
+    if (! counts.instructions || ! counts.cycles) {
+        GTEST_SKIP() << "hardware counters not available";
+    }
+    EXPECT_GE(*counts.instructions, 1000000);
+    EXPECT_GT(*counts.ipc(), 0.0);
+}
+
+TEST(PerfScope, MissingCountersAreEmpty) {
+    kcu::perf_scope scope;
+    const auto counts = scope.counts();
+    if (! counts.cycles || ! counts.instructions) {
+        EXPECT_FALSE(counts.ipc());
+    }
+    scope.reset();
+    EXPECT_EQ(scope.counts().cycles.has_value(), counts.cycles.has_value());
+}
@@ -1,5 +1,13 @@
 #include "src/memory/pool_allocator.hpp"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <vector>
 
 using namespace kcu;
 
@@ -28,4 +36,126 @@ TEST(PoolAllocatorTest, AllocatesAndDeallocatesMultiple) {
     ASSERT_EQ(my_vector.size(), 0);
 
     std::cout << "Done!" << std::endl;
-}
\ No newline at end of file
+}
+
+TEST(PoolAllocatorTest, ReusesFreedBlocks) {
+    memory_pool<1024> mp;
+    void* p1 = mp.allocate(100);
+    mp.deallocate(p1);
+    void* p2 = mp.allocate(100);
+    EXPECT_EQ(p1, p2);
+    mp.deallocate(p2);
+}
+
+TEST(PoolAllocatorTest, CoalescesAdjacentBlocks) {
+    constexpr std::size_t pool_size = 4096;
+    memory_pool<pool_size> mp;
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 16; ++i) {
+        blocks.push_back(mp.allocate(128));
+    }
+    // Free in an interleaved order so both neighbours get merged
+    for (std::size_t i = 0; i < blocks.size(); i += 2) {
+        mp.deallocate(blocks[i]);
+    }
+    for (std::size_t i = 1; i < blocks.size(); i += 2) {
+        mp.deallocate(blocks[i]);
+    }
+
+    // Only possible if every block merged back into one
+    void* p = mp.allocate(pool_size / 2);
+    EXPECT_NE(p, nullptr);
+    mp.deallocate(p);
+}
+
+TEST(PoolAllocatorTest, ThrowsWhenExhausted) {
+    memory_pool<1024> mp;
+    EXPECT_THROW(mp.allocate(0), std::bad_alloc);
+    EXPECT_THROW(mp.allocate(2048), std::bad_alloc);
+    void* p = mp.allocate(512);
+    EXPECT_THROW(mp.allocate(512), std::bad_alloc);
+    mp.deallocate(p);
+}
+
+TEST(PoolAllocatorTest, Alignment) {
+    memory_pool<1 << 16> mp;
+    for (std::size_t align = 1; align <= 4096; align *= 2) {
+        void* p = mp.allocate(24, align);
+        const auto address = reinterpret_cast<std::uintptr_t>(p);
+        EXPECT_EQ(address % std::max(align, alignof(std::max_align_t)), 0);
+        mp.deallocate(p);
+    }
+    EXPECT_THROW(mp.allocate(8, 3), std::bad_alloc);
+}
+
+TEST(PoolAllocatorTest, Churn) {
+    auto mp = std::make_unique<memory_pool<1 << 20>>();
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> size(1, 4096);
+
+    std::vector<std::pair<unsigned char*, std::size_t>> live(256);
+    for (int i = 0; i < 100000; ++i) {
+        auto& [p, n] = live[rng() % live.size()];
+        if (p) {
+            // Check nothing else wrote over the block while it was live
+            for (std::size_t j = 0; j < n; ++j) {
+                ASSERT_EQ(p[j], static_cast<unsigned char>(n));
+            }
+            mp->deallocate(p);
+        }
+        n = size(rng);
+        p = static_cast<unsigned char*>(mp->allocate(n));
+        std::memset(p, static_cast<unsigned char>(n), n);
+    }
+    for (auto& [p, n] : live) {
+        mp->deallocate(p);
+    }
+}
+
+// Random size churn against malloc and the standard pool resource
+TEST(PoolAllocatorTest, Perf) {
+    constexpr int num_ops = 1 << 20;
+    constexpr std::size_t window = 1024;
+    std::vector<std::size_t> sizes(num_ops);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> size(8, 512);
+    for (auto& s : sizes) {
+        s = size(rng);
+    }
+
+    const auto churn = [&](auto allocate, auto deallocate) {
+        std::vector<std::pair<void*, std::size_t>> live(window);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            auto& [p, n] = live[i % window];
+            if (p) {
+                deallocate(p, n);
+            }
+            n = sizes[i];
+            p = allocate(n);
+        }
+        for (auto& [p, n] : live) {
+            deallocate(p, n);
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / num_ops;
+    };
+
+    auto mp = std::make_unique<memory_pool<1 << 22>>();
+    const double pool_ns =
+        churn([&](std::size_t n) { return mp->allocate(n); },
+              [&](void* p, std::size_t) { mp->deallocate(p); });
+    const double malloc_ns =
+        churn([](std::size_t n) { return std::malloc(n); },
+              [](void* p, std::size_t) { std::free(p); });
+    std::pmr::unsynchronized_pool_resource pmr;
+    const double pmr_ns =
+        churn([&](std::size_t n) { return pmr.allocate(n); },
+              [&](void* p, std::size_t n) { pmr.deallocate(p, n); });
+
+    std::cout << "memory_pool: " << pool_ns << "ns/op, malloc: " << malloc_ns
+              << "ns/op, unsynchronized_pool_resource: " << pmr_ns << "ns/op"
+              << std::endl;
+}
@@ -0,0 +1,58 @@
+#include "src/concurrency/sharded_counter.hpp"
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "src/concurrency/padded.hpp"
+
+TEST(Padded, OneObjectPerCacheLine) {
+    using padded_int = kcu::padded<int>;
+    static_assert(alignof(padded_int) ==
+                  kcu::hardware_destructive_interference_size);
+    static_assert(sizeof(padded_int) ==
+                  kcu::hardware_destructive_interference_size);
+
+    std::array<padded_int, 4> slots{padded_int(1), padded_int(2),
+                                    padded_int(3), padded_int(4)};
+    const auto distance = reinterpret_cast<const char*>(&*slots[1]) -
+                          reinterpret_cast<const char*>(&*slots[0]);
+    EXPECT_EQ(distance, kcu::hardware_destructive_interference_size);
+    EXPECT_EQ(*slots[2], 3);
+
+    kcu::padded<std::atomic<int>> counter(5);
+    counter->fetch_add(1);
+    EXPECT_EQ(counter->load(), 6);
+}
+
+TEST(ShardedCounter, SlotsArePowerOfTwo) {
+    EXPECT_EQ(kcu::sharded_counter(1).slots(), 1);
+    EXPECT_EQ(kcu::sharded_counter(5).slots(), 8);
+    EXPECT_GE(kcu::sharded_counter().slots(),
+              std::thread::hardware_concurrency());
+}
+
+TEST(ShardedCounter, ConcurrentUpdates) {
+    constexpr int num_threads = 8;
+    constexpr int increments = 100000;
+    kcu::sharded_counter counter(4);
+    kcu::sharded_counter in_flight;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < increments; ++i) {
+                in_flight.add();
+                counter.add(2);
+                in_flight.sub();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(counter.value(), std::uint64_t(2) * num_threads * increments);
+    // Additions and subtractions landing in different slots still cancel
+    EXPECT_EQ(in_flight.value(), 0);
+}
@@ -1,5 +1,7 @@
 #include "src/concurrency/spsc_queue.hpp"
 #include <gtest/gtest.h>
+#include "sandbox/counting_allocator.hpp"
+#include "src/memory/allocation_tracker.hpp"
 
 using namespace kcu;
 
@@ -24,4 +26,51 @@ TEST(SPSCQueue, Basic) {
     q.pop();
     q.pop();
     EXPECT_TRUE(q.empty());
-}
\ No newline at end of file
+}
+
+TEST(SPSCQueue, WrapAround) {
+    spsc_queue<int> q(4);
+    for (int i = 0; i < 100; ++i) {
+        q.push(int(i));
+        q.push(int(i + 1));
+        EXPECT_EQ(*q.front(), i);
+        q.pop();
+        EXPECT_EQ(*q.front(), i + 1);
+        q.pop();
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(SPSCQueue, CustomAllocator) {
+    allocation_counts counts;
+    {
+        spsc_queue<test_class, counting_allocator<test_class>> q(
+            10, counting_allocator<test_class>(counts));
+        EXPECT_EQ(counts.allocations, 1);
+        EXPECT_EQ(counts.bytes, 10 * sizeof(test_class));
+
+        for (int i = 0; i < 25; ++i) {
+            q.push(test_class());
+            q.push(test_class());
+            q.pop();
+            q.pop();
+        }
+        q.push(test_class());
+        EXPECT_EQ(q.size(), 1);
+        // Pushing and popping never allocates
+        EXPECT_EQ(counts.allocations, 1);
+    }
+    EXPECT_EQ(counts.deallocations, 1);
+    EXPECT_EQ(counts.live_bytes, 0);
+}
+
+TEST(SPSCQueue, PushPopDoNotAllocate) {
+    spsc_queue<int> q(16);
+    no_alloc_scope scope;
+    for (int i = 0; i < 1000; ++i) {
+        q.push(int(i));
+        EXPECT_EQ(*q.front(), i);
+        q.pop();
+    }
+    EXPECT_EQ(scope.allocations(), 0);
+}
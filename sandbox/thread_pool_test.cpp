@@ -1,8 +1,12 @@
 #include "src/concurrency/thread_pool.hpp"
 #include <gtest/gtest.h>
+#include <chrono>
 #include <functional>
 #include <future>
+#include <iostream>
 #include <ranges>
+#include "sandbox/counting_allocator.hpp"
+#include "src/profiling/hdr_histogram.hpp"
 
 TEST(ThreadPool, ScheduleWithReturn) {
     constexpr std::size_t tp_size = 16;
@@ -68,3 +72,56 @@ TEST(ThreadPool, ScheduleWithVoid) {
 
     EXPECT_EQ(i, 2 * tp_size);
 }
+
+TEST(ThreadPool, CustomAllocator) {
+    constexpr std::size_t tp_size = 4;
+    constexpr std::size_t tasks = 64;
+    allocation_counts counts;
+    {
+        kcu::thread_pool<tp_size, counting_allocator<std::byte>> tp{
+            counting_allocator<std::byte>(counts)};
+        const std::size_t initial = counts.allocations;
+
+        std::vector<std::future<int>> futures;
+        futures.reserve(tasks);
+        for (std::size_t i : std::ranges::iota_view{0UL, tasks}) {
+            futures.emplace_back(tp.schedule([](int i) { return i; }, i));
+        }
+        // Each task allocates itself and its promise state
+        EXPECT_GE(counts.allocations - initial, 2 * tasks);
+
+        for (std::size_t i : std::ranges::iota_view{0UL, tasks}) {
+            EXPECT_EQ(futures[i].get(), i);
+        }
+    }
+    EXPECT_EQ(counts.allocations, counts.deallocations);
+    EXPECT_EQ(counts.live_bytes, 0);
+}
+
+TEST(ThreadPool, ScheduleWithException) {
+    kcu::thread_pool<2> tp;
+    auto future = tp.schedule([]() -> int { throw std::runtime_error("x"); });
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+// Latency from scheduling a task until a worker starts running it
+TEST(ThreadPool, Perf) {
+    kcu::thread_pool<4> tp;
+    kcu::hdr_histogram latency;
+    std::vector<std::future<void>> futures(10000);
+    for (auto& f : futures) {
+        f = tp.schedule(
+            [&latency](std::chrono::steady_clock::time_point scheduled) {
+                latency.record(std::chrono::steady_clock::now() - scheduled);
+            },
+            std::chrono::steady_clock::now());
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    EXPECT_EQ(latency.count(), futures.size());
+    std::cout << "Schedule to run latency: p50 " << latency.p50()
+              << " ns, p99 " << latency.p99() << " ns, p999 "
+              << latency.p999() << " ns, max " << latency.max() << " ns"
+              << std::endl;
+}
@@ -0,0 +1,205 @@
+#include "src/concurrency/timer_wheel.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "src/concurrency/thread_pool.hpp"
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+
+TEST(TimerWheel, FiresInOrderNoEarlierThanDue) {
+    kcu::timer_wheel wheel;
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+    const auto start = clock_type::now();
+    std::vector<clock_type::duration> elapsed(4);
+    const std::vector<std::chrono::milliseconds> delays = {30ms, 5ms, 70ms,
+                                                           0ms};
+    for (int i = 0; i < 4; ++i) {
+        wheel.schedule_after(delays[i], [&, i]() {
+            std::lock_guard<std::mutex> lock(mtx);
+            elapsed[i] = clock_type::now() - start;
+            order.push_back(i);
+            if (order.size() == 4) {
+                done.set_value();
+            }
+        });
+    }
+    EXPECT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(order, (std::vector<int>{3, 1, 0, 2}));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_GE(elapsed[i], delays[i]);
+    }
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+TEST(TimerWheel, CascadesAcrossLevels) {
+    // Microsecond ticks, so these delays land in levels 0 to 3
+    kcu::timer_wheel wheel(nullptr, 1us);
+    const std::vector<clock_type::duration> delays = {10us, 200us, 3ms, 8ms,
+                                                      300ms};
+    std::atomic<int> fired = 0;
+    std::atomic<bool> early = false;
+    const auto start = clock_type::now();
+    for (const auto delay : delays) {
+        wheel.schedule_after(delay, [&, delay]() {
+            if (clock_type::now() - start < delay) {
+                early = true;
+            }
+            ++fired;
+        });
+    }
+    const auto deadline = clock_type::now() + 5s;
+    while (fired < int(delays.size()) && clock_type::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(fired, int(delays.size()));
+    EXPECT_FALSE(early);
+}
+
+TEST(TimerWheel, ManyRandomDelays) {
+    kcu::timer_wheel wheel(nullptr, 1us);
+    constexpr int n = 20000;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> us(0, 20000);
+    std::atomic<int> fired = 0;
+    std::atomic<int> early = 0;
+    const auto start = clock_type::now();
+    for (int i = 0; i < n; ++i) {
+        const auto delay = std::chrono::microseconds(us(rng));
+        wheel.schedule_after(delay, [&, delay]() {
+            if (clock_type::now() - start < delay) {
+                ++early;
+            }
+            ++fired;
+        });
+    }
+    const auto deadline = clock_type::now() + 5s;
+    while (fired < n && clock_type::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(fired, n);
+    EXPECT_EQ(early, 0);
+}
+
+TEST(TimerWheel, Cancel) {
+    kcu::timer_wheel wheel;
+    std::atomic<int> fired = 0;
+    auto cancelled = wheel.schedule_after(20ms, [&]() { fired += 100; });
+    EXPECT_EQ(wheel.pending(), 1u);
+    EXPECT_TRUE(cancelled.cancel());
+    EXPECT_FALSE(cancelled.cancel());
+    EXPECT_EQ(wheel.pending(), 0u);
+    auto kept = wheel.schedule_after(1ms, [&]() { ++fired; });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(fired, 1);
+    // Already fired
+    EXPECT_FALSE(kept.cancel());
+    EXPECT_FALSE(kcu::timer_handle().cancel());
+}
+
+TEST(TimerWheel, CancelAfterHandedToBusyPool) {
+    kcu::thread_pool<1> pool;
+    std::promise<void> release;
+    pool.schedule([f = release.get_future()]() { f.wait(); });
+
+    std::promise<void> handed;
+    kcu::timer_wheel wheel([&](std::function<void()> task) {
+        pool.schedule(std::move(task));
+        handed.set_value();
+    });
+    std::atomic<bool> ran = false;
+    auto handle = wheel.schedule_after(1ms, [&]() { ran = true; });
+    ASSERT_EQ(handed.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(wheel.pending(), 0u);
+
+    // Queued behind the blocked task, so not started yet
+    EXPECT_TRUE(handle.cancel());
+    EXPECT_FALSE(handle.cancel());
+    release.set_value();
+    pool.schedule([]() {}).wait();
+    EXPECT_FALSE(ran);
+}
+
+TEST(TimerWheel, HandlesOutliveTheWheel) {
+    kcu::timer_handle handle;
+    {
+        kcu::timer_wheel wheel;
+        handle = wheel.schedule_after(1h, []() {});
+    }
+    EXPECT_FALSE(handle.cancel());
+}
+
+TEST(TimerWheel, ScheduleOnThreadPool) {
+    kcu::thread_pool<2> pool;
+    std::promise<std::thread::id> ran_on;
+    std::atomic<int> arg = 0;
+    pool.schedule_after(
+        5ms,
+        [&](int x) {
+            arg = x;
+            ran_on.set_value(std::this_thread::get_id());
+        },
+        42);
+    auto f = ran_on.get_future();
+    ASSERT_EQ(f.wait_for(5s), std::future_status::ready);
+    EXPECT_NE(f.get(), std::this_thread::get_id());
+    EXPECT_EQ(arg, 42);
+}
+
+TEST(TimerWheel, ScheduleEvery) {
+    kcu::thread_pool<2> pool;
+    std::atomic<int> runs = 0;
+    auto handle = pool.schedule_every(2ms, [&]() { ++runs; });
+    const auto deadline = clock_type::now() + 5s;
+    while (runs < 5 && clock_type::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_TRUE(handle.cancel());
+    // A run already handed to the pool may still finish
+    std::this_thread::sleep_for(10ms);
+    const int after_cancel = runs;
+    std::this_thread::sleep_for(20ms);
+    EXPECT_GE(after_cancel, 5);
+    EXPECT_EQ(runs, after_cancel);
+}
+
+TEST(TimerWheel, Perf) {
+    // A million pending timers, e.g. one timeout per connection
+    constexpr int n = 1000000;
+    kcu::timer_wheel wheel;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> seconds(10, 100000);
+    std::vector<kcu::timer_handle> handles;
+    handles.reserve(n);
+
+    auto start = clock_type::now();
+    for (int i = 0; i < n; ++i) {
+        handles.push_back(
+            wheel.schedule_after(std::chrono::seconds(seconds(rng)), []() {}));
+    }
+    const auto schedule_time = clock_type::now() - start;
+    EXPECT_EQ(wheel.pending(), std::size_t(n));
+
+    std::shuffle(handles.begin(), handles.end(), rng);
+    start = clock_type::now();
+    for (auto& h : handles) {
+        h.cancel();
+    }
+    const auto cancel_time = clock_type::now() - start;
+    EXPECT_EQ(wheel.pending(), 0u);
+
+    const auto per_op = [](clock_type::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    std::cout << "timer_wheel with " << n << " timers: schedule "
+              << per_op(schedule_time) << " ns, cancel "
+              << per_op(cancel_time) << " ns" << std::endl;
+}
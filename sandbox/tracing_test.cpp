@@ -0,0 +1,124 @@
+#include "src/profiling/tracing.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "src/concurrency/caching/async_cache_in_memory.hpp"
+#include "src/concurrency/thread_pool.hpp"
+
+namespace {
+
+std::string trace_json() {
+    std::ostringstream os;
+    kcu::tracing::write_chrome_trace(os);
+    return os.str();
+}
+
+std::size_t count(const std::string& s, const std::string& pattern) {
+    std::size_t n = 0;
+    for (auto pos = s.find(pattern); pos != std::string::npos;
+         pos = s.find(pattern, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+}  // namespace
+
+TEST(Tracing, ScopesAndInstants) {
+    if constexpr (! kcu::tracing::compiled_in) {
+        GTEST_SKIP() << "tracing compiled out";
+    }
+    kcu::tracing::clear();
+    kcu::tracing::start();
+    std::thread t([]() {
+        kcu::tracing::set_thread_name("tracing \"test\" thread");
+        KCU_TRACE_SCOPE("test::outer");
+        KCU_TRACE_SCOPE("test::inner");
+        KCU_TRACE_INSTANT("test::instant");
+    });
+    t.join();
+    kcu::tracing::stop();
+    // Not recorded once stopped
+    KCU_TRACE_INSTANT("test::after_stop");
+
+    const auto json = trace_json();
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(count(json, "\"name\":\"test::outer\",\"ph\":\"X\""), 1u);
+    EXPECT_EQ(count(json, "\"name\":\"test::inner\",\"ph\":\"X\""), 1u);
+    EXPECT_EQ(count(json, "\"name\":\"test::instant\",\"ph\":\"i\""), 1u);
+    EXPECT_EQ(count(json, "test::after_stop"), 0u);
+    EXPECT_EQ(count(json, "\"name\":\"tracing \\\"test\\\" thread\""), 1u);
+}
+
+TEST(Tracing, RingBufferKeepsLatestEvents) {
+    if constexpr (! kcu::tracing::compiled_in) {
+        GTEST_SKIP() << "tracing compiled out";
+    }
+    kcu::tracing::clear();
+    kcu::tracing::start();
+    std::thread t([]() {
+        for (std::size_t i = 0; i < kcu::tracing::buffer_events + 100; ++i) {
+            KCU_TRACE_INSTANT("test::overflow");
+        }
+    });
+    t.join();
+    kcu::tracing::stop();
+    // The oldest slot is the next one to be written, so is left out
+    EXPECT_EQ(count(trace_json(), "test::overflow"),
+              kcu::tracing::buffer_events - 1);
+
+    kcu::tracing::clear();
+    EXPECT_EQ(count(trace_json(), "test::overflow"), 0u);
+}
+
+TEST(Tracing, InstrumentedComponents) {
+    if constexpr (! kcu::tracing::compiled_in) {
+        GTEST_SKIP() << "tracing compiled out";
+    }
+    kcu::tracing::clear();
+    kcu::tracing::start();
+    {
+        kcu::thread_pool<2> pool;
+        for (int i = 0; i < 10; ++i) {
+            pool.schedule([]() {}).get();
+        }
+        kcu::async_cache_in_memory<int, int> cache;
+        cache.get(1, []() { return 1; }).get();
+    }
+    kcu::tracing::stop();
+
+    const auto json = trace_json();
+    EXPECT_EQ(count(json, "\"thread_pool::task\""), 10u);
+    EXPECT_EQ(count(json, "\"thread_pool::queued\""), 10u);
+    EXPECT_EQ(count(json, "\"async_cache::load\""), 1u);
+}
+
+TEST(Tracing, Perf) {
+    if constexpr (! kcu::tracing::compiled_in) {
+        GTEST_SKIP() << "tracing compiled out";
+    }
+    constexpr int n = 1000000;
+    const auto time = [](auto f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(
+                   std::chrono::steady_clock::now() - start)
+                   .count() /
+               n;
+    };
+    const auto spans = []() {
+        for (int i = 0; i < n; ++i) {
+            KCU_TRACE_SCOPE("test::perf");
+        }
+    };
+    const double off = time(spans);
+    kcu::tracing::start();
+    const double on = time(spans);
+    kcu::tracing::stop();
+    kcu::tracing::clear();
+    std::cout << "Trace span: " << off << " ns disabled, " << on
+              << " ns enabled" << std::endl;
+}
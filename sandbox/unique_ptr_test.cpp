@@ -1,6 +1,14 @@
 #include "src/memory/unique_ptr.hpp"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include "src/memory/allocation_tracker.hpp"
+#include "src/memory/inplace_box.hpp"
+#include "src/memory/intrusive_ptr.hpp"
 
 namespace {
 
@@ -14,6 +22,66 @@ struct X {
     int x_;
 };
 
+struct stage {
+    virtual ~stage() = default;
+    virtual int apply(int x) const = 0;
+};
+
+struct add final : stage {
+    explicit add(int n, int* destroyed = nullptr)
+        : n(n), destroyed(destroyed) {}
+    add(add&& other) noexcept
+        : n(other.n), destroyed(std::exchange(other.destroyed, nullptr)) {}
+    ~add() override {
+        if (destroyed) {
+            ++*destroyed;
+        }
+    }
+    int apply(int x) const override { return x + n; }
+
+    int n;
+    int* destroyed;
+};
+
+struct scale final : stage {
+    explicit scale(int n) : n(n) {}
+    int apply(int x) const override { return x * n; }
+    int n;
+};
+
+struct big final : stage {
+    int apply(int x) const override { return x + int(sizeof(padding)); }
+    char padding[256] = {};
+};
+
+// stage is not the first base, so its address differs from the object's
+struct tagged final : X, stage {
+    tagged() : X(7) {}
+    int apply(int x) const override { return x + X::x(); }
+};
+
+struct message : kcu::intrusive_ref_counter<message> {
+    explicit message(int id, int* destroyed = nullptr)
+        : id(id), destroyed(destroyed) {}
+    virtual ~message() {
+        if (destroyed) {
+            ++*destroyed;
+        }
+    }
+    int id;
+    int* destroyed;
+};
+
+struct priority_message : message {
+    using message::message;
+    int priority = 1;
+};
+
+struct local_node
+    : kcu::intrusive_ref_counter<local_node, kcu::ref_counting::non_atomic> {
+    int value = 0;
+};
+
 }  // namespace
 
 TEST(SmartPointer, UniquePtr) {
@@ -68,3 +136,209 @@ TEST(SmartPointer, UniquePtr) {
         EXPECT_EQ((*u1).x(), 1);
     }
 }
+
+TEST(SmartPointer, UniquePtrStatelessDeleterTakesNoSpace) {
+    static_assert(sizeof(kcu::unique_ptr<int>) == sizeof(int*));
+    static_assert(sizeof(kcu::unique_ptr<int[]>) == sizeof(int*));
+    const auto del = [](int* p) { delete p; };
+    static_assert(sizeof(kcu::unique_ptr<int, decltype(del)>) == sizeof(int*));
+}
+
+TEST(SmartPointer, UniquePtrResetRelease) {
+    int deletions = 0;
+    const auto del = [&deletions](int* p) {
+        ++deletions;
+        delete p;
+    };
+    kcu::unique_ptr<int, decltype(del)> u(nullptr, del);
+
+    // Nothing to delete
+    u.reset(new int(1));
+    EXPECT_EQ(deletions, 0);
+    u.reset(new int(2));
+    EXPECT_EQ(deletions, 1);
+
+    int* p = u.release();
+    EXPECT_FALSE(u);
+    EXPECT_TRUE(u == nullptr);
+    EXPECT_EQ(*p, 2);
+    u.reset(p);
+    u.reset();
+    EXPECT_EQ(deletions, 2);
+}
+
+TEST(SmartPointer, UniquePtrArray) {
+    auto a = kcu::make_unique<int[]>(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(a[i], 0);
+        a[i] = i;
+    }
+    auto b = std::move(a);
+    EXPECT_FALSE(a);
+    EXPECT_EQ(b[3], 3);
+}
+
+TEST(SmartPointer, UniquePtrToBase) {
+    int destroyed = 0;
+    kcu::unique_ptr<stage> s = kcu::make_unique<add>(2, &destroyed);
+    EXPECT_EQ(s->apply(1), 3);
+    s = kcu::make_unique<scale>(3);
+    EXPECT_EQ(destroyed, 1);
+    EXPECT_EQ(s->apply(2), 6);
+}
+
+TEST(SmartPointer, InplaceBoxStoresSmallObjectsInline) {
+    int destroyed = 0;
+    {
+        kcu::no_alloc_scope scope;
+        kcu::inplace_box<stage> a(add(2, &destroyed));
+        EXPECT_TRUE(a.is_inline());
+        EXPECT_EQ(a->apply(1), 3);
+
+        // Moving relocates the object into the other box
+        kcu::inplace_box<stage> b = std::move(a);
+        EXPECT_FALSE(a);
+        EXPECT_EQ(b->apply(1), 3);
+        EXPECT_EQ(destroyed, 0);
+
+        b.emplace<scale>(3);
+        EXPECT_EQ(destroyed, 1);
+        EXPECT_EQ((*b).apply(2), 6);
+
+        a = kcu::make_inplace_box<stage, tagged>();
+        EXPECT_NE(static_cast<void*>(a.get()), static_cast<void*>(&a));
+        EXPECT_EQ(a->apply(1), 8);
+        b = std::move(a);
+        EXPECT_EQ(b->apply(1), 8);
+        EXPECT_EQ(scope.allocations(), 0);
+    }
+}
+
+TEST(SmartPointer, InplaceBoxFallsBackToHeap) {
+    kcu::no_alloc_scope scope;
+    kcu::inplace_box<stage> a(std::in_place_type<big>);
+    EXPECT_FALSE(a.is_inline());
+    EXPECT_EQ(scope.allocations(), 1);
+
+    auto* object = a.get();
+    auto b = std::move(a);
+    EXPECT_EQ(b.get(), object);
+    EXPECT_EQ(b->apply(0), 256);
+    EXPECT_EQ(scope.allocations(), 1);
+}
+
+TEST(SmartPointer, InplaceBoxPerf) {
+    constexpr int num_stages = 1000000;
+
+    const auto time = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+
+    // A pipeline of small polymorphic stages, built then run
+    const auto run = [](const auto& stages) {
+        int x = 0;
+        for (const auto& s : stages) {
+            x = s->apply(x);
+        }
+        return x;
+    };
+
+    std::vector<std::unique_ptr<stage>> heap;
+    std::vector<kcu::inplace_box<stage>> boxed;
+    heap.reserve(num_stages);
+    boxed.reserve(num_stages);
+    const double heap_build = time([&]() {
+        for (int i = 0; i < num_stages; ++i) {
+            heap.push_back(i % 2 ? std::unique_ptr<stage>(new add(1))
+                                 : std::unique_ptr<stage>(new scale(1)));
+        }
+    });
+    const double boxed_build = time([&]() {
+        for (int i = 0; i < num_stages; ++i) {
+            if (i % 2) {
+                boxed.emplace_back(add(1));
+            } else {
+                boxed.emplace_back(scale(1));
+            }
+        }
+    });
+    int heap_result = 0;
+    int boxed_result = 0;
+    const double heap_run = time([&]() { heap_result = run(heap); });
+    const double boxed_run = time([&]() { boxed_result = run(boxed); });
+    EXPECT_EQ(heap_result, num_stages / 2);
+    EXPECT_EQ(boxed_result, heap_result);
+
+    std::cout << "std::unique_ptr: build " << heap_build << "ms, run "
+              << heap_run << "ms" << std::endl;
+    std::cout << "kcu::inplace_box: build " << boxed_build << "ms, run "
+              << boxed_run << "ms" << std::endl;
+}
+
+TEST(SmartPointer, IntrusivePtr) {
+    static_assert(sizeof(kcu::intrusive_ptr<message>) == sizeof(message*));
+
+    int destroyed = 0;
+    {
+        auto p = kcu::make_intrusive<message>(1, &destroyed);
+        EXPECT_EQ(p->use_count(), 1);
+        {
+            auto copy = p;
+            EXPECT_EQ(p->use_count(), 2);
+            EXPECT_TRUE(copy == p);
+            kcu::intrusive_ptr<message> moved = std::move(copy);
+            EXPECT_FALSE(copy);
+            EXPECT_EQ(p->use_count(), 2);
+        }
+        EXPECT_EQ(p->use_count(), 1);
+
+        // A raw pointer can be turned back into an owning one
+        kcu::intrusive_ptr<message> from_raw(p.get());
+        EXPECT_EQ(p->use_count(), 2);
+        message* raw = from_raw.detach();
+        kcu::intrusive_ptr<message> adopted(raw, false);
+        EXPECT_EQ(p->use_count(), 2);
+
+        kcu::intrusive_ptr<message> base =
+            kcu::make_intrusive<priority_message>(2, &destroyed);
+        EXPECT_EQ(base->id, 2);
+        base = p;
+        EXPECT_EQ(destroyed, 1);
+        EXPECT_EQ(p->use_count(), 3);
+        p.reset();
+        EXPECT_TRUE(p == nullptr);
+    }
+    EXPECT_EQ(destroyed, 2);
+}
+
+TEST(SmartPointer, IntrusivePtrCopiedAcrossThreads) {
+    int destroyed = 0;
+    auto p = kcu::make_intrusive<message>(1, &destroyed);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([p]() {
+            for (int i = 0; i < 100000; ++i) {
+                auto copy = p;
+                EXPECT_EQ(copy->id, 1);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(p->use_count(), 1);
+    p.reset();
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(SmartPointer, IntrusivePtrNonAtomic) {
+    auto p = kcu::make_intrusive<local_node>();
+    std::vector<kcu::intrusive_ptr<local_node>> copies(10, p);
+    EXPECT_EQ(p->use_count(), 11);
+    copies.clear();
+    EXPECT_EQ(p->use_count(), 1);
+}
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <queue>
 #include <thread>
+#include "src/profiling/tracing.hpp"
 
 namespace kcu {
 
@@ -29,6 +30,7 @@ class async_logger : public logger_interface {
         while (! log_queue_.empty()) {
             auto task = std::move(log_queue_.front());
             log_queue_.pop();
+            KCU_TRACE_SCOPE("async_logger::flush");
             task.get();
         }
     }
@@ -45,6 +47,7 @@ class async_logger : public logger_interface {
                           << "] " << message << std::endl;
             });
         log_queue_.push(std::move(task));
+        KCU_TRACE_INSTANT("async_logger::log");
     }
 
     async_logger(const async_logger&) = delete;
@@ -59,6 +62,7 @@ class async_logger : public logger_interface {
             if (! log_queue_.empty()) {
                 auto task = std::move(log_queue_.front());
                 log_queue_.pop();
+                KCU_TRACE_SCOPE("async_logger::flush");
                 task.get();
             } else {
                 // Sleep for a short duration to avoid busy-waiting
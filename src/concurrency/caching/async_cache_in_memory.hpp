@@ -1,35 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
 #include "src/concurrency/caching/async_cache_interface.hpp"
+#include "src/concurrency/caching/cache_stats.hpp"
+#include "src/concurrency/hardware_interference_size.hpp"
+#include "src/data_structures/flat_hash_map.hpp"
+#include "src/data_structures/intrusive_list.hpp"
+#include "src/profiling/tracing.hpp"
 
 namespace kcu {
 
-template <typename K, typename V>
+// Keys are spread over Shards independently locked shards, each with its own
+// counters, so that concurrent lookups of different keys rarely contend.
+//
+// With a capacity, each shard holds at most capacity / Shards (rounded up)
+// entries and evicts its least recently used loaded entry beyond that.
+// Entries being loaded are not evicted.
+template <typename K, typename V, std::size_t Shards = 16>
 class async_cache_in_memory : public async_cache_interface<K, V> {
+    static_assert(Shards > 0, "Cache must have at least one shard");
+
    public:
     async_cache_in_memory() = default;
 
+    // Tiered cache: misses are forwarded to next_tier (e.g. an
+    // async_cache_persistent) and the returned future is promoted into memory
+    explicit async_cache_in_memory(
+        std::shared_ptr<async_cache_interface<K, V>> next_tier)
+        : next_tier_(std::move(next_tier)) {}
+
+    explicit async_cache_in_memory(
+        std::size_t capacity,
+        std::shared_ptr<async_cache_interface<K, V>> next_tier = nullptr)
+        : shard_capacity_(std::max<std::size_t>(
+              1, (capacity + Shards - 1) / Shards)),
+          next_tier_(std::move(next_tier)) {}
+
+    ~async_cache_in_memory() override {
+        // Loads record into the shard counters, so let them finish first
+        for (auto& shard : shards_) {
+            for (auto& [key, entry] : shard.cache) {
+                entry.future.wait();
+            }
+        }
+    }
+
+    async_cache_in_memory(const async_cache_in_memory&) = delete;
+    async_cache_in_memory& operator=(const async_cache_in_memory&) = delete;
+
     // Retrieve a value from the cache asynchronously
     std::shared_future<V> get(const K& key,
                               const std::function<V()>& eval) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (const auto it = cache_.find(key); it != cache_.end()) {
+        auto& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (const auto it = shard.cache.find(key); it != shard.cache.end()) {
             // If the key is found in the cache, return the associated future
-            return it->second;
+            auto& entry = it->second;
+            if (is_ready(entry.future)) {
+                shard.counters.record_hit();
+            } else {
+                shard.counters.record_coalesced_wait();
+            }
+            shard.lru.move_to_back(entry);
+            return entry.future;
+        }
+
+        shard.counters.record_miss();
+        if (next_tier_) {
+            // Otherwise look it up in the next tier, which evaluates on a miss
+            auto future = next_tier_->get(key, eval);
+            insert(shard, key, future);
+            return future;
         } else {
             // If the key is not in the cache, create a future using the
             // provided eval function
-            auto future = std::async(std::launch::async, [this, key, eval]() {
-                              V fetched_value = eval();
-                              return fetched_value;
-                          }).share();
+            shard.counters.start_load();
+            auto future =
+                std::async(std::launch::async,
+                           [&counters = shard.counters, eval]() {
+                               KCU_TRACE_SCOPE("async_cache::load");
+                               detail::cache_counters::load_timer timer(
+                                   counters);
+                               V fetched_value = eval();
+                               return fetched_value;
+                           })
+                    .share();
             // Store the future in the cache for future access
-            cache_[key] = future;
+            insert(shard, key, future);
             return future;
         }
     }
 
+    // Counters summed over all shards
+    cache_stats stats() const override {
+        cache_stats stats;
+        for (const auto& shard : shards_) {
+            stats += shard.counters.snapshot();
+        }
+        return stats;
+    }
+
+    // Counters of each shard, to spot hot shards
+    std::array<cache_stats, Shards> shard_stats() const {
+        std::array<cache_stats, Shards> stats;
+        for (std::size_t i = 0; i < Shards; ++i) {
+            stats[i] = shards_[i].counters.snapshot();
+        }
+        return stats;
+    }
+
    private:
-    std::unordered_map<K, std::shared_future<V>> cache_;
-    std::mutex mutex_;
+    // The map relocates entries when it grows, the hook follows them but a
+    // pointer to the key in the map would not, so the key is copied
+    struct entry {
+        explicit entry(const K& key) : key(key) {}
+
+        std::shared_future<V> future;
+        K key;
+        intrusive_list_hook lru_hook;
+    };
+
+    struct alignas(hardware_destructive_interference_size) shard {
+        detail::cache_counters counters;
+        flat_hash_map<K, entry> cache;
+        // Least recently used first, unlinked before the entries are destroyed
+        intrusive_list<entry, &entry::lru_hook> lru;
+        std::mutex mutex;
+    };
+
+    static bool is_ready(const std::shared_future<V>& future) {
+        return future.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+    }
+
+    void insert(shard& shard, const K& key, std::shared_future<V> future) {
+        auto [it, inserted] = shard.cache.try_emplace(key, key);
+        auto& entry = it->second;
+        entry.future = std::move(future);
+        shard.lru.push_back(entry);
+
+        // Entries still loading are skipped, destroying the last reference to
+        // a std::async future would wait for the load under the lock
+        auto lru_it = shard.lru.begin();
+        while (shard.cache.size() > shard_capacity_ &&
+               lru_it != shard.lru.end()) {
+            auto& victim = *lru_it;
+            if (&victim == &entry || ! is_ready(victim.future)) {
+                ++lru_it;
+                continue;
+            }
+            lru_it = shard.lru.erase(victim);
+            shard.cache.erase(victim.key);
+            shard.counters.record_eviction();
+        }
+    }
+
+    shard& shard_for(const K& key) {
+        return shards_[std::hash<K>{}(key) % Shards];
+    }
+
+    std::array<shard, Shards> shards_;
+    std::size_t shard_capacity_ = std::numeric_limits<std::size_t>::max();
+    std::shared_ptr<async_cache_interface<K, V>> next_tier_;
 };
 
-}  // namespace kcu
\ No newline at end of file
+}  // namespace kcu
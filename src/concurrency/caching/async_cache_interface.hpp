@@ -1,5 +1,8 @@
+#pragma once
+
 #include <functional>
 #include <future>
+#include "src/concurrency/caching/cache_stats.hpp"
 
 namespace kcu {
 
@@ -15,7 +18,10 @@ class async_cache_interface {
     virtual std::shared_future<V> get(const K& key,
                                       const std::function<V()>& eval) = 0;
 
+    // Snapshot of the hit, miss and load counters
+    virtual cache_stats stats() const = 0;
+
     // Cache purging: TODO
 };
 
-}  // namespace kcu
\ No newline at end of file
+}  // namespace kcu
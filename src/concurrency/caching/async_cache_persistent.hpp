@@ -0,0 +1,303 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include "src/concurrency/caching/async_cache_interface.hpp"
+#include "src/concurrency/caching/cache_stats.hpp"
+#include "src/concurrency/caching/serializer.hpp"
+#include "src/profiling/tracing.hpp"
+
+namespace kcu {
+
+// Disk backed cache using a memory-mapped, append-only data file. Every
+// evaluated value is appended to the file and the in-memory index of key to
+// record offset is rebuilt from the file on construction, so a restarted
+// process starts warm. Can be used standalone or as the next tier of an
+// async_cache_in_memory.
+//
+// File layout: file_header, followed by records of
+// [record_header][key bytes][value bytes], each padded to 8 bytes. A record
+// only becomes visible once file_header::end has been moved past it, so a torn
+// append is ignored when the file is reopened.
+template <typename K, typename V, typename KeySerializer = serializer<K>,
+          typename ValueSerializer = serializer<V>>
+requires concepts::serializer_for<KeySerializer, K> &&
+    concepts::serializer_for<ValueSerializer, V>
+class async_cache_persistent : public async_cache_interface<K, V> {
+   public:
+    explicit async_cache_persistent(const std::filesystem::path& path,
+                                    std::size_t initial_capacity = 1 << 20) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to open " + path.string());
+        }
+        try {
+            open_data_file(initial_capacity);
+        } catch (...) {
+            close_data_file();
+            throw;
+        }
+    }
+
+    ~async_cache_persistent() override {
+        // Outstanding evaluations append to the file, so let them finish first
+        for (auto& worker : workers_) {
+            worker.wait();
+        }
+        ::msync(data_, capacity_, MS_SYNC);
+        close_data_file();
+    }
+
+    async_cache_persistent(const async_cache_persistent&) = delete;
+    async_cache_persistent(async_cache_persistent&&) noexcept = delete;
+    async_cache_persistent& operator=(const async_cache_persistent&) = delete;
+    async_cache_persistent& operator=(async_cache_persistent&&) noexcept =
+        delete;
+
+    // Retrieve a value from the cache asynchronously
+    // Persisted values are read back from the data file, otherwise the
+    // evaluation function is scheduled on a separate thread and its result is
+    // appended to the file once available
+    std::shared_future<V> get(const K& key,
+                              const std::function<V()>& eval) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reap_workers();
+        if (const auto it = index_.find(key); it != index_.end()) {
+            counters_.record_hit();
+            std::promise<V> promise;
+            promise.set_value(read_value(it->second));
+            return promise.get_future().share();
+        }
+        if (const auto it = loading_.find(key); it != loading_.end()) {
+            // Already being evaluated, share the pending result
+            counters_.record_coalesced_wait();
+            return it->second;
+        }
+
+        counters_.record_miss();
+        counters_.start_load();
+        std::promise<V> promise;
+        auto future = promise.get_future().share();
+        loading_.emplace(key, future);
+        workers_.push_back(std::async(
+            std::launch::async,
+            [this, key, eval, promise = std::move(promise)]() mutable {
+                try {
+                    V value = [this, &eval]() {
+                        KCU_TRACE_SCOPE("async_cache::load");
+                        detail::cache_counters::load_timer timer(counters_);
+                        return eval();
+                    }();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        append(key, value);
+                        loading_.erase(key);
+                    }
+                    promise.set_value(std::move(value));
+                } catch (...) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        loading_.erase(key);
+                    }
+                    promise.set_exception(std::current_exception());
+                }
+            }));
+        return future;
+    }
+
+    cache_stats stats() const override { return counters_.snapshot(); }
+
+    // Number of values persisted in the data file
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return index_.size();
+    }
+
+    // Synchronously write the mapped data file back to disk
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (::msync(data_, capacity_, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to flush cache data file");
+        }
+    }
+
+   private:
+    static constexpr std::uint64_t magic = 0x4b43555f43414348;  // "KCU_CACH"
+    static constexpr std::uint64_t version = 1;
+
+    struct file_header {
+        std::uint64_t magic;
+        std::uint64_t version;
+        std::uint64_t end;  // Offset one past the last committed record
+    };
+
+    struct record_header {
+        std::uint64_t key_size;
+        std::uint64_t value_size;
+    };
+
+    static std::size_t record_size(std::size_t key_size,
+                                   std::size_t value_size) {
+        const std::size_t size = sizeof(record_header) + key_size + value_size;
+        return (size + alignof(std::uint64_t) - 1) &
+               ~(alignof(std::uint64_t) - 1);
+    }
+
+    file_header* header() const {
+        return reinterpret_cast<file_header*>(data_);
+    }
+
+    void open_data_file(std::size_t initial_capacity) {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to stat cache data file");
+        }
+
+        capacity_ = static_cast<std::size_t>(st.st_size);
+        const bool fresh = capacity_ == 0;
+        if (fresh) {
+            resize_file(std::max(initial_capacity, sizeof(file_header)));
+        }
+        map_file();
+
+        if (fresh) {
+            *header() = file_header{magic, version, sizeof(file_header)};
+        } else if (capacity_ < sizeof(file_header) ||
+                   header()->magic != magic || header()->version != version) {
+            throw std::runtime_error("Not a cache data file");
+        }
+        rebuild_index();
+    }
+
+    void close_data_file() {
+        if (data_) {
+            ::munmap(data_, capacity_);
+            data_ = nullptr;
+        }
+        ::close(fd_);
+    }
+
+    void resize_file(std::size_t capacity) {
+        if (::ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to resize cache data file");
+        }
+        capacity_ = capacity;
+    }
+
+    void map_file() {
+        void* data = ::mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "Failed to map cache data file");
+        }
+        data_ = static_cast<char*>(data);
+    }
+
+    // Grow the file (geometrically) so that it holds at least size bytes
+    void reserve(std::size_t size) {
+        if (size <= capacity_) {
+            return;
+        }
+        ::munmap(data_, capacity_);
+        data_ = nullptr;
+        resize_file(std::max(2 * capacity_, size));
+        map_file();
+    }
+
+    void rebuild_index() {
+        const std::size_t end = header()->end;
+        if (end < sizeof(file_header) || end > capacity_) {
+            throw std::runtime_error("Corrupt cache data file");
+        }
+
+        std::size_t offset = sizeof(file_header);
+        while (offset < end) {
+            // Sizes come from the file, so each record must fit before end,
+            // checked without overflowing on corrupt sizes
+            std::size_t remaining = end - offset;
+            if (remaining < sizeof(record_header)) {
+                throw std::runtime_error("Corrupt cache data file");
+            }
+            record_header record;
+            std::memcpy(&record, data_ + offset, sizeof(record_header));
+            remaining -= sizeof(record_header);
+            if (record.key_size > remaining ||
+                record.value_size > remaining - record.key_size ||
+                record_size(record.key_size, record.value_size) >
+                    end - offset) {
+                throw std::runtime_error("Corrupt cache data file");
+            }
+            // Later records for the same key take precedence
+            index_.insert_or_assign(
+                KeySerializer::read(data_ + offset + sizeof(record_header),
+                                    record.key_size),
+                offset);
+            offset += record_size(record.key_size, record.value_size);
+        }
+    }
+
+    V read_value(std::size_t offset) const {
+        record_header record;
+        std::memcpy(&record, data_ + offset, sizeof(record_header));
+        return ValueSerializer::read(
+            data_ + offset + sizeof(record_header) + record.key_size,
+            record.value_size);
+    }
+
+    void append(const K& key, const V& value) {
+        const std::size_t key_size = KeySerializer::size(key);
+        const std::size_t value_size = ValueSerializer::size(value);
+        const std::size_t offset = header()->end;
+        const std::size_t end = offset + record_size(key_size, value_size);
+        reserve(end);
+
+        const record_header record{key_size, value_size};
+        std::memcpy(data_ + offset, &record, sizeof(record_header));
+        KeySerializer::write(key, data_ + offset + sizeof(record_header));
+        ValueSerializer::write(
+            value, data_ + offset + sizeof(record_header) + key_size);
+
+        // Commit the record
+        header()->end = end;
+        index_.insert_or_assign(key, offset);
+    }
+
+    // Drop the handles of evaluations which have finished
+    void reap_workers() {
+        std::erase_if(workers_, [](const std::future<void>& worker) {
+            return worker.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+        });
+    }
+
+    int fd_ = -1;
+    char* data_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::unordered_map<K, std::size_t> index_;
+    std::unordered_map<K, std::shared_future<V>> loading_;
+    std::list<std::future<void>> workers_;
+    detail::cache_counters counters_;
+    mutable std::mutex mutex_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace kcu {
+
+// Point in time snapshot of a cache's counters
+struct cache_stats {
+    // Bucket i counts loads taking [2^(i-1), 2^i) microseconds, bucket 0
+    // counts loads under a microsecond and the last bucket everything slower
+    static constexpr std::size_t load_time_buckets = 32;
+
+    std::uint64_t hits = 0;
+    // Hits on a value which was still being loaded
+    std::uint64_t coalesced_waits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t in_flight_loads = 0;
+    std::array<std::uint64_t, load_time_buckets> load_time_histogram{};
+
+    cache_stats& operator+=(const cache_stats& other) {
+        hits += other.hits;
+        coalesced_waits += other.coalesced_waits;
+        misses += other.misses;
+        evictions += other.evictions;
+        in_flight_loads += other.in_flight_loads;
+        for (std::size_t i = 0; i < load_time_buckets; ++i) {
+            load_time_histogram[i] += other.load_time_histogram[i];
+        }
+        return *this;
+    }
+};
+
+namespace detail {
+
+    // Counters updated on the cache hot paths. All updates are relaxed: a
+    // snapshot is not a consistent cut across counters, but each counter is
+    // exact.
+    class cache_counters {
+       public:
+        // Times a load from construction to destruction
+        class load_timer {
+           public:
+            explicit load_timer(cache_counters& counters)
+                : counters_(counters),
+                  start_(std::chrono::steady_clock::now()) {}
+            load_timer(const load_timer&) = delete;
+            load_timer& operator=(const load_timer&) = delete;
+            ~load_timer() {
+                counters_.finish_load(std::chrono::steady_clock::now() -
+                                      start_);
+            }
+
+           private:
+            cache_counters& counters_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+        void record_hit() { hits_.fetch_add(1, std::memory_order_relaxed); }
+
+        void record_coalesced_wait() {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            coalesced_waits_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void record_miss() { misses_.fetch_add(1, std::memory_order_relaxed); }
+
+        void record_eviction() {
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Call when a load is scheduled and construct a load_timer around
+        // the load itself
+        void start_load() {
+            in_flight_loads_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        cache_stats snapshot() const {
+            cache_stats stats;
+            stats.hits = hits_.load(std::memory_order_relaxed);
+            stats.coalesced_waits =
+                coalesced_waits_.load(std::memory_order_relaxed);
+            stats.misses = misses_.load(std::memory_order_relaxed);
+            stats.evictions = evictions_.load(std::memory_order_relaxed);
+            stats.in_flight_loads =
+                in_flight_loads_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < cache_stats::load_time_buckets; ++i) {
+                stats.load_time_histogram[i] =
+                    load_time_histogram_[i].load(std::memory_order_relaxed);
+            }
+            return stats;
+        }
+
+       private:
+        void finish_load(std::chrono::nanoseconds elapsed) {
+            const auto us = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                    .count());
+            const std::size_t bucket =
+                std::min<std::size_t>(std::bit_width(us),
+                                      cache_stats::load_time_buckets - 1);
+            load_time_histogram_[bucket].fetch_add(1,
+                                                   std::memory_order_relaxed);
+            in_flight_loads_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<std::uint64_t> hits_ = 0;
+        std::atomic<std::uint64_t> coalesced_waits_ = 0;
+        std::atomic<std::uint64_t> misses_ = 0;
+        std::atomic<std::uint64_t> evictions_ = 0;
+        std::atomic<std::uint64_t> in_flight_loads_ = 0;
+        std::array<std::atomic<std::uint64_t>, cache_stats::load_time_buckets>
+            load_time_histogram_{};
+    };
+
+}  // namespace detail
+
+}  // namespace kcu
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace kcu {
+
+// Serialization hooks used by the persistent caches. Specialise serializer<T>
+// (or pass a custom serializer type) to store types which are neither
+// trivially copyable nor strings.
+template <typename T>
+struct serializer;
+
+template <typename T>
+requires std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+struct serializer<T> {
+    static std::size_t size(const T&) noexcept { return sizeof(T); }
+
+    static void write(const T& t, char* out) noexcept {
+        std::memcpy(out, &t, sizeof(T));
+    }
+
+    static T read(const char* in, std::size_t /**/) noexcept {
+        T t;
+        std::memcpy(&t, in, sizeof(T));
+        return t;
+    }
+};
+
+template <>
+struct serializer<std::string> {
+    static std::size_t size(const std::string& s) noexcept { return s.size(); }
+
+    static void write(const std::string& s, char* out) noexcept {
+        std::memcpy(out, s.data(), s.size());
+    }
+
+    static std::string read(const char* in, std::size_t size) {
+        return std::string(in, size);
+    }
+};
+
+namespace concepts {
+
+    template <typename S, typename T>
+    concept serializer_for = requires(const T& t, char* out, const char* in,
+                                      std::size_t n) {
+        { S::size(t) } -> std::convertible_to<std::size_t>;
+        S::write(t, out);
+        { S::read(in, n) } -> std::convertible_to<T>;
+    };
+
+}  // namespace concepts
+
+}  // namespace kcu
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "src/concurrency/hardware_interference_size.hpp"
+
+namespace kcu {
+
+namespace detail {
+
+    // Shared state of an epoch_domain. As for concurrent_memory_pool, threads
+    // reference it weakly from a thread-local table, so a thread exiting after
+    // the domain was destroyed does not touch freed memory.
+    class epoch_state {
+       public:
+        // Each thread attempts to advance the epoch and free its retired
+        // objects after this many retirements
+        static constexpr std::size_t collect_interval = 64;
+
+        struct retired {
+            void* p;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+        };
+
+        // Per thread state. epoch holds the global epoch observed when the
+        // thread was pinned, shifted left by one with the low bit set, or 0
+        // when the thread is not pinned.
+        struct alignas(hardware_destructive_interference_size) record {
+            std::atomic<std::uint64_t> epoch = 0;
+            std::size_t depth = 0;
+            std::size_t retired_since_collect = 0;
+            std::vector<retired> retired_objects;
+            std::atomic<bool> in_use = true;
+            record* next = nullptr;
+        };
+
+        epoch_state() : id_(next_id()) {}
+        epoch_state(const epoch_state&) = delete;
+        epoch_state& operator=(const epoch_state&) = delete;
+
+        ~epoch_state() {
+            record* r = records_.load(std::memory_order_acquire);
+            while (r) {
+                for (auto& o : r->retired_objects) {
+                    o.deleter(o.p);
+                }
+                record* next = r->next;
+                delete r;
+                r = next;
+            }
+        }
+
+        std::uint64_t id() const noexcept { return id_; }
+
+        std::uint64_t epoch() const noexcept {
+            return epoch_.load(std::memory_order_seq_cst);
+        }
+
+        void pin(record& r) noexcept {
+            if (r.depth++ == 0) {
+                const auto epoch = epoch_.load(std::memory_order_seq_cst);
+                r.epoch.store((epoch << 1) | 1, std::memory_order_relaxed);
+                // Loads of shared pointers must not be reordered before the
+                // announcement
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        void unpin(record& r) noexcept {
+            if (--r.depth == 0) {
+                r.epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        void retire(record& r, void* p, void (*deleter)(void*)) {
+            r.retired_objects.push_back(
+                {p, deleter, epoch_.load(std::memory_order_seq_cst)});
+            if (++r.retired_since_collect >= collect_interval) {
+                collect(r);
+            }
+        }
+
+        // Objects retired in epoch e may still be referenced by threads
+        // pinned in e or e + 1, and are freed once the epoch reaches e + 2
+        void collect(record& r) {
+            r.retired_since_collect = 0;
+            try_advance();
+            const auto epoch = epoch_.load(std::memory_order_seq_cst);
+            std::erase_if(r.retired_objects, [epoch](const retired& o) {
+                if (o.epoch + 2 <= epoch) {
+                    o.deleter(o.p);
+                    return true;
+                }
+                return false;
+            });
+        }
+
+        // Claim an unused record, or create one
+        record* acquire_record() {
+            for (record* r = records_.load(std::memory_order_acquire); r;
+                 r = r->next) {
+                bool in_use = false;
+                if (r->in_use.compare_exchange_strong(in_use, true)) {
+                    return r;
+                }
+            }
+            record* r = new record;
+            r->next = records_.load(std::memory_order_relaxed);
+            while (! records_.compare_exchange_weak(
+                r->next, r, std::memory_order_release,
+                std::memory_order_relaxed)) {
+            }
+            return r;
+        }
+
+        // Return the record of an exiting thread. Objects it retired which
+        // are not yet safe to free are freed by the next thread adopting it,
+        // or by the domain's destructor.
+        void release_record(record& r) {
+            collect(r);
+            r.in_use.store(false, std::memory_order_release);
+        }
+
+       private:
+        static std::uint64_t next_id() {
+            static std::atomic<std::uint64_t> id = 0;
+            return ++id;
+        }
+
+        // Advance the epoch if every pinned thread has observed it
+        void try_advance() noexcept {
+            auto epoch = epoch_.load(std::memory_order_seq_cst);
+            for (record* r = records_.load(std::memory_order_acquire); r;
+                 r = r->next) {
+                const auto e = r->epoch.load(std::memory_order_seq_cst);
+                if ((e & 1) && (e >> 1) != epoch) {
+                    return;
+                }
+            }
+            epoch_.compare_exchange_strong(epoch, epoch + 1,
+                                           std::memory_order_seq_cst);
+        }
+
+        std::uint64_t id_;
+        alignas(hardware_destructive_interference_size)
+            std::atomic<std::uint64_t> epoch_ = 0;
+        alignas(hardware_destructive_interference_size)
+            std::atomic<record*> records_ = nullptr;
+    };
+
+}  // namespace detail
+
+// Epoch based memory reclamation for lock-free data structures. Threads
+// access shared nodes only while pinned by a guard; a node unlinked from a
+// structure is retired rather than deleted, and deleted once every thread
+// pinned at the time has unpinned. Pinning is a store and a fence, so reads
+// are cheap, but a thread stalled while pinned delays all reclamation.
+class epoch_domain {
+    using state = detail::epoch_state;
+
+   public:
+    epoch_domain() : state_(std::make_shared<state>()) {}
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    // Shared by data structures not given a domain of their own
+    static epoch_domain& default_domain() {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    // Pins the current thread for its lifetime. Guards nest.
+    class guard {
+       public:
+        explicit guard(epoch_domain& domain)
+            : state_(*domain.state_), record_(domain.local_record()) {
+            state_.pin(record_);
+        }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+        ~guard() { state_.unpin(record_); }
+
+       private:
+        state& state_;
+        state::record& record_;
+    };
+
+    void retire(void* p, void (*deleter)(void*)) {
+        state_->retire(local_record(), p, deleter);
+    }
+
+    template <typename T>
+    void retire(T* p) {
+        retire(p, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Try to advance the epoch and free the current thread's retired objects
+    // which are no longer referenced
+    void collect() { state_->collect(local_record()); }
+
+    std::uint64_t epoch() const noexcept { return state_->epoch(); }
+
+   private:
+    // Records this thread uses, one per domain, released when it exits
+    struct thread_records {
+        struct entry {
+            std::uint64_t domain_id;
+            state::record* record;
+            std::weak_ptr<state> domain;
+        };
+
+        ~thread_records() {
+            for (auto& e : entries) {
+                if (auto domain = e.domain.lock()) {
+                    domain->release_record(*e.record);
+                }
+            }
+        }
+
+        std::vector<entry> entries;
+        // Most recently used entry
+        std::uint64_t last_domain_id = 0;
+        state::record* last_record = nullptr;
+    };
+
+    state::record& local_record() {
+        static thread_local thread_records records;
+        if (records.last_domain_id == state_->id()) {
+            return *records.last_record;
+        }
+
+        state::record* record = nullptr;
+        std::erase_if(records.entries, [&](const thread_records::entry& e) {
+            if (e.domain_id == state_->id()) {
+                record = e.record;
+            }
+            return e.domain.expired();
+        });
+        if (! record) {
+            record = state_->acquire_record();
+            records.entries.push_back({state_->id(), record, state_});
+        }
+        records.last_domain_id = state_->id();
+        records.last_record = record;
+        return *record;
+    }
+
+    std::shared_ptr<state> state_;
+};
+
+}  // namespace kcu
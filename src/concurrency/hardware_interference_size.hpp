@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace kcu {
+
+// Minimum distance between two objects to avoid false sharing, and maximum
+// size of contiguous memory to promote true sharing. GCC warns that
+// std::hardware_destructive_interference_size may differ between translation
+// units compiled with different -mtune, which is accepted here so that every
+// header uses the one definition.
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr std::size_t hardware_destructive_interference_size =
+    std::hardware_destructive_interference_size;
+inline constexpr std::size_t hardware_constructive_interference_size =
+    std::hardware_constructive_interference_size;
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr std::size_t hardware_destructive_interference_size = 64;
+inline constexpr std::size_t hardware_constructive_interference_size = 64;
+#endif
+
+}  // namespace kcu
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "src/concurrency/epoch_reclamation.hpp"
+
+namespace kcu {
+
+// Lock-free sorted set as a singly linked list (Harris, with Michael's
+// reclamation friendly unlinking). A node is erased in two steps: marking the
+// low bit of its next pointer logically deletes it, and any thread which then
+// finds it while searching unlinks it from its predecessor. Unlinked nodes are
+// retired to an epoch_domain.
+template <typename T, typename Compare = std::less<T>>
+class lock_free_list {
+    struct node {
+        T value;
+        std::atomic<node*> next = nullptr;
+    };
+
+    static bool is_marked(node* n) {
+        return reinterpret_cast<std::uintptr_t>(n) & 1;
+    }
+    static node* marked(node* n) {
+        return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(n) |
+                                       1);
+    }
+    static node* unmarked(node* n) {
+        return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(n) &
+                                       ~std::uintptr_t{1});
+    }
+
+   public:
+    explicit lock_free_list(
+        epoch_domain& domain = epoch_domain::default_domain(),
+        const Compare& compare = Compare())
+        : domain_(domain), compare_(compare) {}
+    lock_free_list(const lock_free_list&) = delete;
+    lock_free_list& operator=(const lock_free_list&) = delete;
+
+    ~lock_free_list() {
+        node* n = head_.load(std::memory_order_relaxed);
+        while (n) {
+            node* next = unmarked(n->next.load(std::memory_order_relaxed));
+            delete n;
+            n = next;
+        }
+    }
+
+    // False if an equivalent value is already present
+    bool insert(T value) {
+        epoch_domain::guard guard(domain_);
+        node* n = new node{std::move(value)};
+        for (;;) {
+            auto [prev, curr] = find(n->value);
+            if (curr && ! compare_(n->value, curr->value)) {
+                delete n;
+                return false;
+            }
+            n->next.store(curr, std::memory_order_relaxed);
+            if (prev->compare_exchange_strong(curr, n,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    bool erase(const T& value) {
+        epoch_domain::guard guard(domain_);
+        for (;;) {
+            auto [prev, curr] = find(value);
+            if (! curr || compare_(value, curr->value)) {
+                return false;
+            }
+            node* next = curr->next.load(std::memory_order_acquire);
+            if (is_marked(next)) {
+                continue;
+            }
+            // Logical deletion, the thread marking the node owns the erase
+            if (! curr->next.compare_exchange_strong(
+                    next, marked(next), std::memory_order_acq_rel,
+                    std::memory_order_relaxed)) {
+                continue;
+            }
+            if (prev->compare_exchange_strong(curr, next,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+                domain_.retire(curr);
+            } else {
+                // Let a search unlink it
+                find(value);
+            }
+            return true;
+        }
+    }
+
+    // Wait-free traversal, marked nodes are skipped but not unlinked
+    bool contains(const T& value) const {
+        epoch_domain::guard guard(domain_);
+        node* curr = head_.load(std::memory_order_acquire);
+        while (curr && compare_(curr->value, value)) {
+            curr = unmarked(curr->next.load(std::memory_order_acquire));
+        }
+        return curr && ! compare_(value, curr->value) &&
+               ! is_marked(curr->next.load(std::memory_order_acquire));
+    }
+
+    // Visit the values present, in order. Only meaningful while no thread
+    // modifies the list.
+    template <typename F>
+    void for_each(F&& f) const {
+        epoch_domain::guard guard(domain_);
+        node* curr = head_.load(std::memory_order_acquire);
+        while (curr) {
+            node* next = curr->next.load(std::memory_order_acquire);
+            if (! is_marked(next)) {
+                f(curr->value);
+            }
+            curr = unmarked(next);
+        }
+    }
+
+   private:
+    // Link pointing to the first node not less than value, and that node,
+    // unlinking marked nodes on the way. Must be called while pinned.
+    std::pair<std::atomic<node*>*, node*> find(const T& value) {
+        for (;;) {
+            std::atomic<node*>* prev = &head_;
+            node* curr = prev->load(std::memory_order_acquire);
+            bool restart = false;
+            while (curr) {
+                node* next = curr->next.load(std::memory_order_acquire);
+                if (is_marked(next)) {
+                    // Fails if prev was marked or changed, then restart
+                    if (! prev->compare_exchange_strong(
+                            curr, unmarked(next), std::memory_order_acq_rel,
+                            std::memory_order_acquire)) {
+                        restart = true;
+                        break;
+                    }
+                    domain_.retire(curr);
+                    curr = unmarked(next);
+                    continue;
+                }
+                if (! compare_(curr->value, value)) {
+                    break;
+                }
+                prev = &curr->next;
+                curr = next;
+            }
+            if (! restart) {
+                return {prev, curr};
+            }
+        }
+    }
+
+    epoch_domain& domain_;
+    [[no_unique_address]] Compare compare_;
+    std::atomic<node*> head_ = nullptr;
+};
+
+}  // namespace kcu
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "src/concurrency/hardware_interference_size.hpp"
+
+namespace kcu {
+
+// Single producer multicast ring buffer, after the LMAX Disruptor: the
+// producer publishes each value once, into a preallocated slot, and every
+// consumer reads every value in order from the same slot, tracking its own
+// sequence. Where spsc_queue needs a queue, and a copy of each value, per
+// consumer, here consumers only share the producer's cursor.
+//
+// The producer never overwrites a slot some consumer has not read yet, so
+// the slowest consumer gates it. A consumer may depend on others, and then
+// reads a value only after they are done with it, e.g. a strategy only
+// after the risk checker, which forms a pipeline over the same slots.
+//
+// Consumers must be added before the producer starts. Each consumer is used
+// by one thread, and the producer by one thread. Slots are default
+// constructed up front and assigned to when published, and consumers see
+// them as const.
+template <typename T, typename Allocator = std::allocator<T>>
+class multicast_ring final {
+    static_assert(std::is_default_constructible_v<T>,
+                  "Slots are constructed up front");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+   public:
+    class consumer {
+       public:
+        consumer(const consumer&) = delete;
+        consumer& operator=(const consumer&) = delete;
+
+        // Number of values this consumer may read now
+        std::size_t available() noexcept {
+            return std::size_t(refresh() -
+                               sequence_.load(std::memory_order_relaxed));
+        }
+
+        // Call f(value) for up to max_batch available values, in order, and
+        // release them to the producer and dependent consumers at once.
+        // Returns the number read, 0 if none was available.
+        template <typename F>
+        std::size_t poll(F&& f, std::size_t max_batch = SIZE_MAX) {
+            const auto seq = sequence_.load(std::memory_order_relaxed);
+            // The shared cursor is read only when the values known to be
+            // available do not fill the batch
+            if (cached_available_ - seq < max_batch && refresh() == seq) {
+                return 0;
+            }
+            const auto n = std::min<std::uint64_t>(cached_available_ - seq,
+                                                   max_batch);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                f(std::as_const(ring_.slot(seq + i)));
+            }
+            sequence_.store(seq + n, std::memory_order_release);
+            return std::size_t(n);
+        }
+
+        // Sequence of the next value to read, i.e. the number read so far
+        std::uint64_t sequence() const noexcept {
+            return sequence_.load(std::memory_order_relaxed);
+        }
+
+       private:
+        friend class multicast_ring;
+
+        consumer(multicast_ring& ring, std::vector<const consumer*> deps,
+                 std::uint64_t start)
+            : ring_(ring),
+              dependencies_(std::move(deps)),
+              cached_available_(start),
+              sequence_(start) {}
+
+        // Values up to which this consumer may read, limited by the
+        // producer and the consumers it depends on
+        std::uint64_t refresh() noexcept {
+            auto limit = ring_.cursor_.load(std::memory_order_acquire);
+            for (const consumer* dep : dependencies_) {
+                limit = std::min(
+                    limit, dep->sequence_.load(std::memory_order_acquire));
+            }
+            cached_available_ = limit;
+            return limit;
+        }
+
+        multicast_ring& ring_;
+        const std::vector<const consumer*> dependencies_;
+        std::uint64_t cached_available_;
+        alignas(hardware_destructive_interference_size)
+            std::atomic<std::uint64_t> sequence_;
+    };
+
+    // Capacity is rounded up to a power of two
+    explicit multicast_ring(std::size_t capacity,
+                            const Allocator& alloc = Allocator())
+        : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+          mask_(capacity_ - 1),
+          alloc_(alloc) {
+        slots_ = alloc_traits::allocate(alloc_, capacity_);
+        std::size_t constructed = 0;
+        try {
+            for (; constructed < capacity_; ++constructed) {
+                alloc_traits::construct(alloc_, slots_ + constructed);
+            }
+        } catch (...) {
+            destroy_slots(constructed);
+            throw;
+        }
+    }
+
+    multicast_ring(const multicast_ring&) = delete;
+    multicast_ring& operator=(const multicast_ring&) = delete;
+
+    ~multicast_ring() { destroy_slots(capacity_); }
+
+    // Add a consumer reading values published from now on, each only after
+    // every consumer in dependencies has read it. Not thread-safe; add all
+    // consumers before publishing.
+    consumer& add_consumer(
+        std::initializer_list<const consumer*> dependencies = {}) {
+        for (const consumer* dep : dependencies) {
+            if (&dep->ring_ != this) {
+                throw std::invalid_argument(
+                    "multicast_ring: dependency of another ring");
+            }
+        }
+        const auto start = cursor_.load(std::memory_order_relaxed);
+        consumers_.push_back(std::unique_ptr<consumer>(
+            new consumer(*this, {dependencies.begin(), dependencies.end()},
+                         start)));
+        return *consumers_.back();
+    }
+
+    // Publish value once there is a free slot, spinning then yielding
+    // while the slowest consumer holds the ring full
+    template <typename U>
+    void publish(U&& value) {
+        for (unsigned spins = 0; ! has_free_slot(); ++spins) {
+            if (spins >= 64) {
+                std::this_thread::yield();
+            }
+        }
+        write(std::forward<U>(value));
+    }
+
+    // Publish value if there is a free slot
+    template <typename U>
+    bool try_publish(U&& value) {
+        if (! has_free_slot()) {
+            return false;
+        }
+        write(std::forward<U>(value));
+        return true;
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // Number of values published
+    std::uint64_t cursor() const noexcept {
+        return cursor_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    T& slot(std::uint64_t seq) noexcept { return slots_[seq & mask_]; }
+
+    bool has_free_slot() noexcept {
+        if (next_ - gate_ < capacity_) {
+            return true;
+        }
+        // Refresh the cached minimum of the consumers' sequences. The
+        // acquire pairs with their release, so their reads of a slot are
+        // done before it is overwritten.
+        auto gate = next_;
+        for (const auto& c : consumers_) {
+            gate = std::min(gate,
+                            c->sequence_.load(std::memory_order_acquire));
+        }
+        gate_ = gate;
+        return next_ - gate_ < capacity_;
+    }
+
+    template <typename U>
+    void write(U&& value) {
+        slot(next_) = std::forward<U>(value);
+        ++next_;
+        cursor_.store(next_, std::memory_order_release);
+    }
+
+    void destroy_slots(std::size_t n) noexcept {
+        for (std::size_t i = 0; i < n; ++i) {
+            alloc_traits::destroy(alloc_, slots_ + i);
+        }
+        alloc_traits::deallocate(alloc_, slots_, capacity_);
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    [[no_unique_address]] Allocator alloc_;
+    T* slots_;
+    std::vector<std::unique_ptr<consumer>> consumers_;
+
+    // Producer only: the next sequence to publish, and the minimum of the
+    // consumers' sequences when last read
+    alignas(hardware_destructive_interference_size) std::uint64_t next_ = 0;
+    std::uint64_t gate_ = 0;
+    // Read by every consumer
+    alignas(hardware_destructive_interference_size)
+        std::atomic<std::uint64_t> cursor_ = 0;
+};
+
+}  // namespace kcu
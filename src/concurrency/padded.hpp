@@ -0,0 +1,25 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include "src/concurrency/hardware_interference_size.hpp"
+
+namespace kcu {
+
+// A T alone on its cache line(s), so that writes to neighbouring objects,
+// e.g. other elements of an array of per-thread slots, do not invalidate it
+template <typename T>
+struct alignas(hardware_destructive_interference_size) padded {
+    template <typename... Args>
+        requires std::is_constructible_v<T, Args...>
+    explicit padded(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    T& operator*() noexcept { return value; }
+    const T& operator*() const noexcept { return value; }
+    T* operator->() noexcept { return &value; }
+    const T* operator->() const noexcept { return &value; }
+
+    T value;
+};
+
+}  // namespace kcu
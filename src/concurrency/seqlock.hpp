@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include "src/concurrency/hardware_interference_size.hpp"
+
+namespace kcu {
+
+// Sequence lock holding a small trivially copyable value, e.g. a config
+// struct read by many threads and occasionally updated. Readers copy the
+// value and retry if a write overlapped the copy, so they never write to
+// shared memory and never block the writer. Unlike with a shared_mutex,
+// whose reader count every reader writes, reads on different cores do not
+// contend. Writers are serialized by the sequence itself.
+//
+// Readers copy the whole value on every load and spin while a write is in
+// progress, so the value should be at most a few cache lines. Larger or
+// non-trivially copyable state is better published through a
+// kcu::snapshot.
+template <typename T>
+class alignas(hardware_destructive_interference_size) seqlock final {
+    static_assert(std::is_trivially_copyable_v<T> &&
+                      std::is_default_constructible_v<T>,
+                  "seqlock values are copied bytewise");
+
+    // The value is copied in and out through relaxed atomic words, so that a
+    // read racing with a write is not a data race, only a discarded copy
+    using word = std::uint64_t;
+    static constexpr std::size_t words = (sizeof(T) + sizeof(word) - 1) /
+                                         sizeof(word);
+
+   public:
+    seqlock() noexcept : seqlock(T()) {}
+
+    explicit seqlock(const T& value) noexcept { write(value); }
+
+    seqlock(const seqlock&) = delete;
+    seqlock& operator=(const seqlock&) = delete;
+
+    T load() const noexcept {
+        while (true) {
+            const auto seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::array<word, words> copy;
+            for (std::size_t i = 0; i < words; ++i) {
+                copy[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            // The copy is complete before the sequence is checked again
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) {
+                T value;
+                std::memcpy(static_cast<void*>(&value), copy.data(),
+                            sizeof(T));
+                return value;
+            }
+        }
+    }
+
+    void store(const T& value) noexcept {
+        // An odd sequence marks a write in progress and excludes other
+        // writers
+        auto seq = seq_.load(std::memory_order_relaxed);
+        while ((seq & 1) ||
+               ! seq_.compare_exchange_weak(seq, seq + 1,
+                                            std::memory_order_relaxed)) {
+            if (seq & 1) {
+                std::this_thread::yield();
+                seq = seq_.load(std::memory_order_relaxed);
+            }
+        }
+        // Readers seeing any of the new words also see the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        write(value);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+   private:
+    void write(const T& value) noexcept {
+        std::array<word, words> copy{};
+        std::memcpy(copy.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < words; ++i) {
+            data_[i].store(copy[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> seq_ = 0;
+    std::array<std::atomic<word>, words> data_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "src/concurrency/padded.hpp"
+
+namespace kcu {
+
+// Counter for updates from many threads, split into slots on separate cache
+// lines. A thread adds to the slot of the CPU it runs on, so concurrent
+// updates rarely touch the same line; a thread migrating between CPUs only
+// makes it share a slot for a moment, as slots are still updated
+// atomically. Reading sums the slots: exact once updates stop, and never
+// torn while they run, but not a snapshot of a single instant.
+class sharded_counter {
+   public:
+    // One slot per hardware thread, rounded up to a power of two
+    sharded_counter()
+        : sharded_counter(std::max(1u, std::thread::hardware_concurrency())) {
+    }
+
+    explicit sharded_counter(std::size_t slots)
+        : mask_(std::bit_ceil(std::max<std::size_t>(slots, 1)) - 1),
+          slots_(std::make_unique<slot[]>(mask_ + 1)) {}
+
+    sharded_counter(const sharded_counter&) = delete;
+    sharded_counter& operator=(const sharded_counter&) = delete;
+
+    void add(std::uint64_t n = 1) noexcept {
+        slots_[slot_index() & mask_]->fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Wraps around like unsigned arithmetic, so a counter of values going up
+    // and down (e.g. in flight operations) sums correctly
+    void sub(std::uint64_t n = 1) noexcept {
+        slots_[slot_index() & mask_]->fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            sum += slots_[i]->load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    std::size_t slots() const noexcept { return mask_ + 1; }
+
+   private:
+    using slot = padded<std::atomic<std::uint64_t>>;
+
+    // The current CPU, from the kernel's restartable sequences area on
+    // recent glibc so it costs a load. Threads are numbered round robin
+    // where the CPU is unknown.
+    static std::size_t slot_index() noexcept {
+        if (const int cpu = ::sched_getcpu(); cpu >= 0) {
+            return static_cast<std::size_t>(cpu);
+        }
+        static std::atomic<std::size_t> next_thread = 0;
+        static thread_local const std::size_t thread =
+            next_thread.fetch_add(1, std::memory_order_relaxed);
+        return thread;
+    }
+
+    std::size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "src/concurrency/epoch_reclamation.hpp"
+
+namespace kcu {
+
+// Read-copy-update publication of shared state, e.g. configuration or
+// reference data read by many threads and replaced by one now and then.
+// Readers load the current immutable version through an atomic pointer while
+// pinned to an epoch_domain, which writes only to the reader's own record,
+// so reads on different cores do not contend. Publishing swaps in a new
+// version and retires the old one, deleted once no reader can still see it.
+//
+// A reader holding a version delays reclamation of every version retired
+// meanwhile, so readers should not keep one across blocking calls.
+template <typename T>
+class snapshot final {
+   public:
+    // Pins the current version for the reader's lifetime
+    class reader {
+       public:
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+
+        const T& operator*() const noexcept { return *value_; }
+        const T* operator->() const noexcept { return value_; }
+        const T* get() const noexcept { return value_; }
+
+       private:
+        friend class snapshot;
+
+        explicit reader(const snapshot& s)
+            : guard_(s.domain_),
+              value_(s.current_.load(std::memory_order_acquire)) {}
+
+        epoch_domain::guard guard_;
+        const T* value_;
+    };
+
+    explicit snapshot(T value,
+                      epoch_domain& domain = epoch_domain::default_domain())
+        : domain_(domain), current_(new T(std::move(value))) {}
+
+    snapshot(const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+
+    // Readers must have finished
+    ~snapshot() { delete current_.load(std::memory_order_relaxed); }
+
+    reader read() const { return reader(*this); }
+
+    // Call f with the current version and return its result
+    template <typename F>
+    decltype(auto) read(F&& f) const {
+        reader r(*this);
+        return std::forward<F>(f)(*r);
+    }
+
+    // Replace the current version. Readers already holding the old one keep
+    // it until they finish.
+    void publish(T value) {
+        T* old = current_.exchange(new T(std::move(value)),
+                                   std::memory_order_acq_rel);
+        retire(old);
+    }
+
+    // Publish a modified copy of the current version. Concurrent updates are
+    // not lost: f is applied again to a fresh copy if another version was
+    // published meanwhile.
+    template <typename F>
+    void update(F&& f) {
+        while (true) {
+            epoch_domain::guard guard(domain_);
+            T* expected = current_.load(std::memory_order_acquire);
+            T* next = new T(*expected);
+            try {
+                f(*next);
+            } catch (...) {
+                delete next;
+                throw;
+            }
+            if (current_.compare_exchange_strong(expected, next,
+                                                 std::memory_order_acq_rel)) {
+                retire(expected);
+                return;
+            }
+            delete next;
+        }
+    }
+
+   private:
+    void retire(T* old) {
+        domain_.retire(old);
+        // Publishing is rare, so versions are collected eagerly rather than
+        // after the domain's usual batch of retirements
+        domain_.collect();
+    }
+
+    epoch_domain& domain_;
+    std::atomic<T*> current_;
+};
+
+}  // namespace kcu
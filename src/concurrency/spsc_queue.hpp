@@ -4,19 +4,23 @@
 #include <cstddef>
 #include <memory>
 #include <type_traits>
+#include "src/concurrency/hardware_interference_size.hpp"
 
 namespace kcu {
 
 // Single producer single consumer lock free queue using a ring-buffer.
-// TODO: allow other allocators
-template <typename T>
+// The ring buffer is allocated through Allocator, so it can come from e.g. a
+// kcu::memory_pool or a huge page backed kcu::arena.
+template <typename T, typename Allocator = std::allocator<T>>
 class spsc_queue {
-    using alloc_t = std::allocator<T>;
+    using alloc_t = Allocator;
+    using alloc_traits = std::allocator_traits<alloc_t>;
 
    public:
-    explicit spsc_queue(const std::size_t capacity)
-        : capacity_(capacity), alloc_(alloc_t()) {
-        ring_buffer_ = alloc_.allocate(capacity_);
+    explicit spsc_queue(const std::size_t capacity,
+                        const Allocator& alloc = Allocator())
+        : capacity_(capacity), alloc_(alloc) {
+        ring_buffer_ = alloc_traits::allocate(alloc_, capacity_);
     }
     spsc_queue(const spsc_queue&) = delete;
     spsc_queue& operator=(const spsc_queue&) = delete;
@@ -25,14 +29,14 @@ class spsc_queue {
         while (! empty()) {
             pop();
         }
-        alloc_.deallocate(ring_buffer_, capacity_);
+        alloc_traits::deallocate(alloc_, ring_buffer_, capacity_);
     }
 
     void push(T&& t) noexcept(std::is_nothrow_copy_constructible_v<T>) {
         const auto write_idx = write_idx_.load(std::memory_order_relaxed);
         // Unsigned int automatically wraps around when overflowing
         const std::size_t new_write_idx = write_idx + 1;
-        new (&ring_buffer_[write_idx]) T(std::forward<T>(t));
+        new (&ring_buffer_[write_idx % capacity_]) T(std::forward<T>(t));
         write_idx_.store(new_write_idx, std::memory_order_release);
     }
 
@@ -40,13 +44,13 @@ class spsc_queue {
         const auto read_idx = read_idx_.load(std::memory_order_relaxed);
         // Unsigned int automatically wraps around when overflowing
         const std::size_t new_read_idx = read_idx + 1;
-        ring_buffer_[read_idx].~T();
+        ring_buffer_[read_idx % capacity_].~T();
         read_idx_.store(new_read_idx, std::memory_order_release);
     }
 
     T* front() noexcept {
         const auto read_idx = read_idx_.load(std::memory_order_relaxed);
-        return &ring_buffer_[read_idx];
+        return &ring_buffer_[read_idx % capacity_];
     }
 
     std::size_t size() const noexcept {
@@ -63,20 +67,13 @@ class spsc_queue {
 
    private:
     std::size_t capacity_;
-    std::allocator<T> alloc_;
+    [[no_unique_address]] alloc_t alloc_;
     T* ring_buffer_;
 
-#ifdef __cpp_lib_hardware_interference_size
-    static constexpr std::size_t hardware_destructive_interference_size =
-        std::hardware_destructive_interference_size;
-#else
-    static constexpr std::size_t hardware_destructive_interference_size = 64;
-#endif
-
     alignas(hardware_destructive_interference_size)
         std::atomic<std::size_t> write_idx_;
     alignas(hardware_destructive_interference_size)
         std::atomic<std::size_t> read_idx_;
 };
 
-}  // namespace kcu
\ No newline at end of file
+}  // namespace kcu
@@ -2,22 +2,106 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <ranges>
 #include <semaphore>
 #include <thread>
+#include "src/concurrency/timer_wheel.hpp"
+#include "src/data_structures/intrusive_list.hpp"
+#include "src/profiling/tracing.hpp"
 
 namespace kcu {
 
-template <unsigned N>
+namespace detail {
+
+    // Queued tasks are linked through their own hook, so queuing does not
+    // allocate
+    class pool_task : public intrusive_list_hook {
+       public:
+        virtual void run() = 0;
+        // Destroy and deallocate the task through its allocator
+        virtual void destroy() noexcept = 0;
+
+        // Trace timestamp of scheduling, if tracing was enabled
+        std::uint64_t queued_at = 0;
+
+       protected:
+        ~pool_task() = default;
+    };
+
+    // Bound callable and the promise of its result. The shared state of the
+    // promise is allocated through the pool's allocator as well.
+    template <typename R, typename F, typename Allocator>
+    class pool_task_impl final : public pool_task {
+        using task_allocator = typename std::allocator_traits<
+            Allocator>::template rebind_alloc<pool_task_impl>;
+        using task_traits = std::allocator_traits<task_allocator>;
+
+       public:
+        static pool_task_impl* create(F&& f, const Allocator& alloc) {
+            task_allocator task_alloc(alloc);
+            auto* task = task_traits::allocate(task_alloc, 1);
+            try {
+                return ::new (static_cast<void*>(task))
+                    pool_task_impl(std::move(f), alloc);
+            } catch (...) {
+                task_traits::deallocate(task_alloc, task, 1);
+                throw;
+            }
+        }
+
+        std::future<R> get_future() { return promise_.get_future(); }
+
+        void run() override {
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    f_();
+                    promise_.set_value();
+                } else {
+                    promise_.set_value(f_());
+                }
+            } catch (...) {
+                promise_.set_exception(std::current_exception());
+            }
+        }
+
+        void destroy() noexcept override {
+            task_allocator task_alloc(alloc_);
+            this->~pool_task_impl();
+            task_traits::deallocate(task_alloc, this, 1);
+        }
+
+       private:
+        pool_task_impl(F&& f, const Allocator& alloc)
+            : f_(std::move(f)),
+              promise_(std::allocator_arg, alloc),
+              alloc_(alloc) {}
+
+        F f_;
+        std::promise<R> promise_;
+        [[no_unique_address]] Allocator alloc_;
+    };
+
+}  // namespace detail
+
+// Tasks and their promise state are allocated through Allocator. Tasks are
+// allocated on the scheduling thread and released on the worker or future
+// owning thread, so the allocator must be thread-safe (e.g.
+// kcu::concurrent_pool_allocator), or deallocation free like
+// kcu::arena_allocator when a single thread schedules.
+template <unsigned N, typename Allocator = std::allocator<std::byte>>
 class thread_pool final {
    public:
-    explicit thread_pool() : active_(true) {
+    explicit thread_pool(const Allocator& alloc = Allocator())
+        : active_(true), alloc_(alloc) {
         for (std::size_t i : std::ranges::iota_view{0UL, N}) {
             threads_[i] = std::thread(&thread_pool::worker_thread, this);
         }
@@ -25,11 +109,19 @@ class thread_pool final {
     thread_pool(const thread_pool&) = delete;
     thread_pool& operator=(const thread_pool&) = delete;
     ~thread_pool() {
+        // No more timer tasks once the workers stop
+        timers_.reset();
         active_ = false;
         cs_.release(N);
         for (auto& t : threads_) {
             t.join();
         }
+        // Tasks never run, their futures report a broken promise
+        while (! task_queue_.empty()) {
+            auto& task = task_queue_.front();
+            task_queue_.pop_front();
+            task.destroy();
+        }
     }
 
     template <typename F, typename... Args>
@@ -38,39 +130,84 @@ class thread_pool final {
         using R = std::invoke_result_t<F, Args...>;
         auto bound_f =
             std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        auto task =
-            std::make_shared<std::packaged_task<R()>>(std::move(bound_f));
+        using task_t = detail::pool_task_impl<R, decltype(bound_f), Allocator>;
+        auto* task = task_t::create(std::move(bound_f), alloc_);
         auto future = task->get_future();
+        if (tracing::enabled()) {
+            task->queued_at = tracing::now();
+        }
         {
             std::scoped_lock lock(mtx_);
-            task_queue_.push(
-                [task = std::move(task)]() { task->operator()(); });
+            task_queue_.push_back(*task);
         }
         cs_.release();
         return future;
     }
 
+    // Run f(args...) on the pool after delay. Timers are kept by one timer
+    // thread, started on first use, so pending timers do not hold workers.
+    // The result is discarded; use the handle to cancel.
+    template <typename Rep, typename Period, typename F, typename... Args>
+    requires std::invocable<F, Args...>
+    timer_handle schedule_after(std::chrono::duration<Rep, Period> delay,
+                                F&& f, Args&&... args) {
+        return timers().schedule_after(
+            std::chrono::ceil<timer_wheel::clock::duration>(delay),
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    // Run f(args...) on the pool every period, until cancelled through the
+    // handle or the pool is destroyed
+    template <typename Rep, typename Period, typename F, typename... Args>
+    requires std::invocable<F, Args...>
+    timer_handle schedule_every(std::chrono::duration<Rep, Period> period,
+                                F&& f, Args&&... args) {
+        return timers().schedule_every(
+            std::chrono::ceil<timer_wheel::clock::duration>(period),
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
    private:
+    timer_wheel& timers() {
+        std::call_once(timers_once_, [this]() {
+            timers_ = std::make_unique<timer_wheel>(
+                [this](std::function<void()> task) {
+                    schedule(std::move(task));
+                });
+        });
+        return *timers_;
+    }
+
     void worker_thread() {
-        std::function<void()> task;
         while (active_) {
             cs_.acquire();
             if (active_) {
+                detail::pool_task* task;
                 {
                     std::scoped_lock lock(mtx_);
-                    task = std::move(task_queue_.front());
-                    task_queue_.pop();
+                    task = &task_queue_.front();
+                    task_queue_.pop_front();
+                }
+                if (task->queued_at) {
+                    tracing::complete("thread_pool::queued", task->queued_at);
+                }
+                {
+                    KCU_TRACE_SCOPE("thread_pool::task");
+                    task->run();
                 }
-                task();
+                task->destroy();
             }
         }
     }
 
     std::atomic<bool> active_;
-    std::queue<std::function<void()>> task_queue_;
+    [[no_unique_address]] Allocator alloc_;
+    intrusive_list<detail::pool_task> task_queue_;
     std::array<std::thread, N> threads_;
     std::counting_semaphore<N> cs_{0};
     std::mutex mtx_;
+    std::once_flag timers_once_;
+    std::unique_ptr<timer_wheel> timers_;
 };
 
-}  // namespace kcu
\ No newline at end of file
+}  // namespace kcu
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "src/data_structures/intrusive_list.hpp"
+#include "src/memory/intrusive_ptr.hpp"
+
+namespace kcu {
+
+namespace detail {
+
+    struct timer_node : intrusive_ref_counter<timer_node>,
+                        intrusive_list_hook {
+        timer_node(std::function<void()> f, std::uint64_t period)
+            : f(std::move(f)), period(period) {}
+
+        std::function<void()> f;
+        // Ticks between runs, 0 for a one shot timer
+        const std::uint64_t period;
+        // Tick the timer expires at, and the wheel slot holding it while
+        // pending, guarded by the wheel's mutex
+        std::uint64_t expiry = 0;
+        intrusive_list<timer_node>* slot = nullptr;
+        // Set once cancelled, and for a one shot timer once its run starts,
+        // so that exactly one of the run and cancel() claims it
+        std::atomic<bool> cancelled = false;
+    };
+
+    // Hierarchical timing wheel (Varghese and Lauck): levels of 64 slots,
+    // where a slot of level l holds timers expiring within a span of 64^l
+    // ticks. Timers are inserted into the level matching how far away they
+    // expire, and moved down a level each time the wheel reaches their
+    // slot, so insertion and cancellation are O(1) and each tick touches one
+    // slot (plus, every 64^l ticks, one slot of level l).
+    class timer_core {
+       public:
+        using clock = std::chrono::steady_clock;
+        using executor = std::function<void(std::function<void()>)>;
+
+        static constexpr unsigned slot_bits = 6;
+        static constexpr std::size_t slots = std::size_t(1) << slot_bits;
+        static constexpr std::size_t levels = 6;
+
+        timer_core(executor exec, clock::duration tick)
+            : exec_(std::move(exec)),
+              tick_(std::max(tick, clock::duration(1))),
+              start_(clock::now()) {}
+
+        timer_core(const timer_core&) = delete;
+        timer_core& operator=(const timer_core&) = delete;
+
+        // Schedule f after delay, and every delay after that if periodic
+        intrusive_ptr<timer_node> add(clock::duration delay,
+                                      std::function<void()> f,
+                                      bool periodic) {
+            delay = std::max(delay, clock::duration(0));
+            const auto ticks = ceil_ticks(delay);
+            auto node = make_intrusive<timer_node>(
+                std::move(f), periodic ? std::max<std::uint64_t>(ticks, 1)
+                                       : 0);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                node->cancelled = true;
+                return node;
+            }
+            // The due time is rounded up to a tick, not the current time,
+            // so a timer added partway through a tick never fires early
+            node->expiry = ceil_ticks(clock::now() - start_ + delay);
+            // The wheel references pending timers
+            intrusive_ptr_add_ref(node.get());
+            link(*node);
+            if (node->expiry < next_wakeup_) {
+                wake_.notify_one();
+            }
+            return node;
+        }
+
+        bool cancel(timer_node& node) {
+            intrusive_ptr<timer_node> released;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                // Not pending: a one shot timer handed to the executor is
+                // still skipped if its run has not started, otherwise it ran
+                // or was already cancelled
+                if (! node.slot) {
+                    return node.period == 0 && ! node.cancelled.exchange(true);
+                }
+                node.cancelled = true;
+                unlink(node);
+                released = intrusive_ptr<timer_node>(&node, false);
+            }
+            // Released outside the lock, the node's callback may hold
+            // anything
+            return true;
+        }
+
+        std::size_t pending() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return pending_;
+        }
+
+        // Timer thread body, until stop()
+        void run() {
+            std::vector<intrusive_ptr<timer_node>> expired;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (! stopped_) {
+                const auto target = tick_of(clock::now());
+                while (now_ < target) {
+                    if (pending_ == 0) {
+                        now_ = target;
+                        break;
+                    }
+                    advance(expired);
+                }
+                if (! expired.empty()) {
+                    lock.unlock();
+                    for (auto& node : expired) {
+                        dispatch(std::move(node));
+                    }
+                    expired.clear();
+                    lock.lock();
+                    continue;
+                }
+                if (pending_ == 0) {
+                    next_wakeup_ = UINT64_MAX;
+                    wake_.wait(lock);
+                } else {
+                    next_wakeup_ = next_event();
+                    wake_.wait_until(lock, time_of(next_wakeup_));
+                }
+            }
+        }
+
+        void stop() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+            wake_.notify_one();
+        }
+
+        // Cancel every pending timer, once stopped. Handles may keep the
+        // core alive, but not the timers.
+        void drop_all() {
+            // Declared before the lock, so released after it
+            std::vector<intrusive_ptr<timer_node>> dropped;
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& level : wheel_) {
+                for (auto& slot : level) {
+                    while (! slot.empty()) {
+                        auto& node = slot.front();
+                        unlink(node);
+                        node.cancelled = true;
+                        dropped.emplace_back(&node, false);
+                    }
+                }
+            }
+        }
+
+       private:
+        std::uint64_t tick_of(clock::time_point t) const {
+            return std::uint64_t((t - start_) / tick_);
+        }
+
+        std::uint64_t ceil_ticks(clock::duration d) const {
+            return std::uint64_t((d + tick_ - clock::duration(1)) / tick_);
+        }
+
+        clock::time_point time_of(std::uint64_t tick) const {
+            return start_ + tick_ * tick;
+        }
+
+        // When cascading, advance() processes the level 0 slot of now_ next,
+        // so a timer due now goes there rather than a tick later
+        void link(timer_node& node, bool cascading = false) {
+            // Expired or due now: the next slot the wheel processes
+            const std::uint64_t expiry =
+                std::max(node.expiry, cascading ? now_ : now_ + 1);
+            const std::uint64_t delta = expiry - now_;
+            std::size_t level = 0;
+            while (level + 1 < levels &&
+                   delta >= (std::uint64_t(1) << (slot_bits * (level + 1)))) {
+                ++level;
+            }
+            // Beyond the top level's span, parked in its furthest slot and
+            // placed again from there
+            const std::uint64_t span = std::uint64_t(1)
+                                       << (slot_bits * levels);
+            const std::uint64_t placed =
+                delta < span ? expiry : now_ + span - 1;
+            auto& slot =
+                wheel_[level][(placed >> (slot_bits * level)) & (slots - 1)];
+            slot.push_back(node);
+            node.slot = &slot;
+            ++pending_;
+        }
+
+        void unlink(timer_node& node) {
+            node.slot->erase(node);
+            node.slot = nullptr;
+            --pending_;
+        }
+
+        // Move to the next tick: cascade the higher level slots reached,
+        // then expire the level 0 slot
+        void advance(std::vector<intrusive_ptr<timer_node>>& expired) {
+            ++now_;
+            for (std::size_t level = 1; level < levels; ++level) {
+                const std::uint64_t shift = slot_bits * level;
+                if (now_ & ((std::uint64_t(1) << shift) - 1)) {
+                    break;
+                }
+                auto& slot = wheel_[level][(now_ >> shift) & (slots - 1)];
+                while (! slot.empty()) {
+                    auto& node = slot.front();
+                    unlink(node);
+                    link(node, true);
+                }
+            }
+            auto& slot = wheel_[0][now_ & (slots - 1)];
+            while (! slot.empty()) {
+                auto& node = slot.front();
+                unlink(node);
+                if (node.period) {
+                    // Drift free: the next run is a period after this one
+                    // was due, not after it ran
+                    node.expiry += node.period;
+                    link(node);
+                    expired.emplace_back(&node);
+                } else {
+                    // Hand the wheel's reference over to the dispatch
+                    expired.emplace_back(&node, false);
+                }
+            }
+        }
+
+        void dispatch(intrusive_ptr<timer_node> node) {
+            if (node->cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+            auto run = [node = std::move(node)]() {
+                const bool cancelled =
+                    node->period
+                        ? node->cancelled.load(std::memory_order_relaxed)
+                        : node->cancelled.exchange(true);
+                if (! cancelled) {
+                    node->f();
+                }
+            };
+            if (exec_) {
+                exec_(std::move(run));
+            } else {
+                run();
+            }
+        }
+
+        // Tick of the next non-empty level 0 slot before the next cascade,
+        // or of that cascade
+        std::uint64_t next_event() const {
+            const std::uint64_t boundary = (now_ | (slots - 1)) + 1;
+            for (std::uint64_t t = now_ + 1; t < boundary; ++t) {
+                if (! wheel_[0][t & (slots - 1)].empty()) {
+                    return t;
+                }
+            }
+            return boundary;
+        }
+
+        executor exec_;
+        const clock::duration tick_;
+        const clock::time_point start_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::array<std::array<intrusive_list<timer_node>, slots>, levels>
+            wheel_;
+        // Last tick processed
+        std::uint64_t now_ = 0;
+        std::size_t pending_ = 0;
+        std::uint64_t next_wakeup_ = UINT64_MAX;
+        bool stopped_ = false;
+    };
+
+}  // namespace detail
+
+// Cancels a timer from schedule_after or schedule_every. Handles may be
+// dropped without cancelling, and outlive the timer_wheel.
+class timer_handle {
+   public:
+    timer_handle() = default;
+
+    // Stop the timer. True if a one shot timer's run had not started, even
+    // if already handed to the executor, or for a periodic timer not yet
+    // cancelled; a periodic run already handed over is skipped if it has not
+    // started.
+    bool cancel() {
+        if (! node_) {
+            return false;
+        }
+        return core_->cancel(*node_);
+    }
+
+   private:
+    friend class timer_wheel;
+
+    timer_handle(intrusive_ptr<detail::timer_node> node,
+                 std::shared_ptr<detail::timer_core> core)
+        : node_(std::move(node)), core_(std::move(core)) {}
+
+    intrusive_ptr<detail::timer_node> node_;
+    std::shared_ptr<detail::timer_core> core_;
+};
+
+// Delayed and periodic callbacks, driven by one timer thread. Timers are
+// kept in a hierarchical timing wheel with a resolution of one tick, so
+// scheduling and cancelling are O(1) whatever the number pending, and
+// millions of pending timers cost only their nodes. Timers fire no earlier
+// than due, and up to a tick late plus scheduling delay.
+//
+// Expired callbacks are passed to the executor, e.g. to run them on a
+// thread_pool, or run on the timer thread if there is none, in which case
+// they must be short. Pending timers are dropped with the wheel.
+class timer_wheel final {
+    using core = detail::timer_core;
+
+   public:
+    using clock = core::clock;
+    using executor = core::executor;
+
+    explicit timer_wheel(executor exec = nullptr,
+                         clock::duration tick = std::chrono::milliseconds(1))
+        : core_(std::make_shared<core>(std::move(exec), tick)),
+          thread_([c = core_.get()]() { c->run(); }) {}
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    ~timer_wheel() {
+        core_->stop();
+        thread_.join();
+        core_->drop_all();
+    }
+
+    // Run f once, after delay
+    timer_handle schedule_after(clock::duration delay,
+                                std::function<void()> f) {
+        return {core_->add(delay, std::move(f), false), core_};
+    }
+
+    // Run f every period, starting one period from now. Runs are due at
+    // fixed intervals, and may overlap if f takes longer than the period on
+    // an executor with several threads.
+    timer_handle schedule_every(clock::duration period,
+                                std::function<void()> f) {
+        return {core_->add(period, std::move(f), true), core_};
+    }
+
+    // Timers scheduled and not yet fired or cancelled, periodic ones
+    // included
+    std::size_t pending() const { return core_->pending(); }
+
+   private:
+    std::shared_ptr<core> core_;
+    std::thread thread_;
+};
+
+}  // namespace kcu
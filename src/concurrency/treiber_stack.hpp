@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "src/concurrency/epoch_reclamation.hpp"
+
+namespace kcu {
+
+// Lock-free multi producer multi consumer stack. Popped nodes are retired to
+// an epoch_domain, so a node cannot be freed and reused while another thread
+// is reading it, which also rules out ABA on the head.
+template <typename T>
+class treiber_stack {
+    struct node {
+        T value;
+        node* next = nullptr;
+    };
+
+   public:
+    explicit treiber_stack(
+        epoch_domain& domain = epoch_domain::default_domain())
+        : domain_(domain) {}
+    treiber_stack(const treiber_stack&) = delete;
+    treiber_stack& operator=(const treiber_stack&) = delete;
+
+    ~treiber_stack() {
+        node* n = head_.load(std::memory_order_relaxed);
+        while (n) {
+            node* next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        node* n = new node{T(std::forward<Args>(args)...)};
+        n->next = head_.load(std::memory_order_relaxed);
+        while (! head_.compare_exchange_weak(n->next, n,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+        }
+    }
+
+    void push(T&& value) { emplace(std::forward<T>(value)); }
+
+    std::optional<T> pop() {
+        epoch_domain::guard guard(domain_);
+        node* n = head_.load(std::memory_order_acquire);
+        while (n && ! head_.compare_exchange_weak(n, n->next,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_acquire)) {
+        }
+        if (! n) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(n->value));
+        domain_.retire(n);
+        return value;
+    }
+
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+   private:
+    epoch_domain& domain_;
+    std::atomic<node*> head_ = nullptr;
+};
+
+}  // namespace kcu
@@ -0,0 +1,564 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace kcu {
+
+namespace detail {
+
+    // Control byte of a slot: the 7 low bits of the hash of its key when
+    // full, so that most mismatching slots are rejected without comparing
+    // keys, or one of the special values below, which have the high bit set
+    using ctrl_t = std::int8_t;
+    inline constexpr ctrl_t ctrl_empty = -128;
+    inline constexpr ctrl_t ctrl_deleted = -2;
+
+    // Control bytes of width consecutive slots, matched all at once
+    class ctrl_group {
+       public:
+        static constexpr std::size_t width = 16;
+
+        explicit ctrl_group(const ctrl_t* ctrl) {
+#ifdef __SSE2__
+            ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+            std::memcpy(ctrl_, ctrl, width);
+#endif
+        }
+
+        // Bit i set if slot i has control byte h2
+        std::uint32_t match(ctrl_t h2) const {
+#ifdef __SSE2__
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= std::uint32_t(ctrl_[i] == h2) << i;
+            }
+            return mask;
+#endif
+        }
+
+        std::uint32_t match_empty() const { return match(ctrl_empty); }
+
+        // Empty and deleted slots have the high bit set
+        std::uint32_t match_empty_or_deleted() const {
+#ifdef __SSE2__
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= std::uint32_t(ctrl_[i] < 0) << i;
+            }
+            return mask;
+#endif
+        }
+
+       private:
+#ifdef __SSE2__
+        __m128i ctrl_;
+#else
+        ctrl_t ctrl_[width];
+#endif
+    };
+
+}  // namespace detail
+
+// Open addressing hash map in the style of Swiss tables. Slots are stored in
+// a flat array with a parallel array of control bytes, probed a group of 16
+// at a time (with SSE2 where available), so a lookup usually costs one hash,
+// one group match and one key comparison, and inserting allocates only when
+// the table grows. Erased slots leave tombstones which are reclaimed on the
+// next rehash.
+//
+// Unlike std::unordered_map, references and iterators are invalidated when
+// the table grows. Lookup accepts any key type when both Hash and KeyEqual
+// are transparent (define is_transparent). Slots and control bytes are
+// allocated through Allocator.
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class flat_hash_map {
+    using ctrl_t = detail::ctrl_t;
+    using group = detail::ctrl_group;
+
+    static constexpr bool transparent =
+        requires { typename Hash::is_transparent; } &&
+        requires { typename KeyEqual::is_transparent; };
+
+   public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+   private:
+    using value_allocator = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<value_type>;
+    using value_traits = std::allocator_traits<value_allocator>;
+    using ctrl_allocator = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<ctrl_t>;
+    using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+
+    template <bool Const>
+    class iterator_impl {
+        friend class flat_hash_map;
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = flat_hash_map::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer =
+            std::conditional_t<Const, const value_type*, value_type*>;
+        using reference =
+            std::conditional_t<Const, const value_type&, value_type&>;
+
+        iterator_impl() = default;
+        operator iterator_impl<true>() const { return {ctrl_, slot_, end_}; }
+
+        reference operator*() const { return *slot_; }
+        pointer operator->() const { return slot_; }
+
+        iterator_impl& operator++() {
+            ++ctrl_;
+            ++slot_;
+            skip_free();
+            return *this;
+        }
+        iterator_impl operator++(int) {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const iterator_impl& other) const {
+            return ctrl_ == other.ctrl_;
+        }
+
+       private:
+        iterator_impl(const ctrl_t* ctrl, value_type* slot,
+                      const ctrl_t* end)
+            : ctrl_(ctrl), slot_(slot), end_(end) {}
+
+        void skip_free() {
+            while (ctrl_ != end_ && *ctrl_ < 0) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const ctrl_t* ctrl_ = nullptr;
+        value_type* slot_ = nullptr;
+        const ctrl_t* end_ = nullptr;
+    };
+
+   public:
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    explicit flat_hash_map(const Allocator& alloc = Allocator())
+        : value_alloc_(alloc), ctrl_alloc_(alloc) {}
+
+    flat_hash_map(const flat_hash_map& other)
+        : hash_(other.hash_),
+          eq_(other.eq_),
+          value_alloc_(value_traits::select_on_container_copy_construction(
+              other.value_alloc_)),
+          ctrl_alloc_(ctrl_traits::select_on_container_copy_construction(
+              other.ctrl_alloc_)) {
+        reserve(other.size_);
+        for (const auto& value : other) {
+            insert(value);
+        }
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept
+        : ctrl_(std::exchange(other.ctrl_, nullptr)),
+          slots_(std::exchange(other.slots_, nullptr)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          size_(std::exchange(other.size_, 0)),
+          growth_left_(std::exchange(other.growth_left_, 0)),
+          hash_(other.hash_),
+          eq_(other.eq_),
+          value_alloc_(other.value_alloc_),
+          ctrl_alloc_(other.ctrl_alloc_) {}
+
+    flat_hash_map& operator=(flat_hash_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~flat_hash_map() { destroy(); }
+
+    void swap(flat_hash_map& other) noexcept {
+        using std::swap;
+        swap(ctrl_, other.ctrl_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+        swap(growth_left_, other.growth_left_);
+        swap(hash_, other.hash_);
+        swap(eq_, other.eq_);
+        swap(value_alloc_, other.value_alloc_);
+        swap(ctrl_alloc_, other.ctrl_alloc_);
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    iterator begin() noexcept {
+        iterator it(ctrl_, slots_, ctrl_ + capacity_);
+        it.skip_free();
+        return it;
+    }
+    iterator end() noexcept {
+        return {ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_};
+    }
+    const_iterator begin() const noexcept {
+        return const_cast<flat_hash_map*>(this)->begin();
+    }
+    const_iterator end() const noexcept {
+        return const_cast<flat_hash_map*>(this)->end();
+    }
+
+    iterator find(const K& key) { return find_impl(key); }
+    const_iterator find(const K& key) const { return find_impl(key); }
+    bool contains(const K& key) const { return find_index(key) != npos; }
+    std::size_t count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    // Heterogeneous lookup, e.g. by std::string_view in a map keyed by
+    // std::string, without constructing a K
+    template <typename Key>
+        requires transparent
+    iterator find(const Key& key) {
+        return find_impl(key);
+    }
+    template <typename Key>
+        requires transparent
+    const_iterator find(const Key& key) const {
+        return find_impl(key);
+    }
+    template <typename Key>
+        requires transparent
+    bool contains(const Key& key) const {
+        return find_index(key) != npos;
+    }
+    template <typename Key>
+        requires transparent
+    std::size_t count(const Key& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    V& at(const K& key) {
+        const auto i = find_index(key);
+        if (i == npos) {
+            throw std::out_of_range("Key not found in flat_hash_map.");
+        }
+        return slots_[i].second;
+    }
+    const V& at(const K& key) const {
+        return const_cast<flat_hash_map*>(this)->at(key);
+    }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    // Construct V from args if key is absent, otherwise leave args untouched
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        return emplace_impl(key, std::piecewise_construct,
+                            std::forward_as_tuple(key),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return emplace_impl(key, std::piecewise_construct,
+                            std::forward_as_tuple(std::move(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return emplace_impl(value.first, value);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return emplace_impl(value.first, std::move(value));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (! result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    std::size_t erase(const K& key) { return erase_impl(key); }
+
+    template <typename Key>
+        requires transparent &&
+                 (! std::is_convertible_v<const Key&, const_iterator>)
+    std::size_t erase(const Key& key) {
+        return erase_impl(key);
+    }
+
+    // Returns an iterator to the next element, erasing does not move any
+    iterator erase(const_iterator pos) {
+        const auto i = static_cast<std::size_t>(pos.ctrl_ - ctrl_);
+        erase_at(i);
+        iterator it = iterator_at(i);
+        it.skip_free();
+        return it;
+    }
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+    void clear() noexcept {
+        if (capacity_ == 0) {
+            return;
+        }
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                value_traits::destroy(value_alloc_, slots_ + i);
+            }
+        }
+        std::memset(ctrl_, detail::ctrl_empty, capacity_);
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    // Make room for n elements without rehashing
+    void reserve(std::size_t n) {
+        if (n > size_ + growth_left_) {
+            rehash(capacity_for(n));
+        }
+    }
+
+    float load_factor() const noexcept {
+        return capacity_ == 0 ? 0.0f : float(size_) / float(capacity_);
+    }
+
+   private:
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    // Tables are at most 7/8 full, including tombstones
+    static constexpr std::size_t max_load(std::size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    static std::size_t capacity_for(std::size_t n) {
+        std::size_t capacity = group::width;
+        while (max_load(capacity) < n) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // std::hash of integers is the identity, so mix the bits before taking
+    // the group index from the high bits and the control byte from the low
+    template <typename Key>
+    std::size_t hash_of(const Key& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(hash_(key));
+        h *= 0x9e3779b97f4a7c15ull;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+
+    static ctrl_t h2(std::size_t hash) { return ctrl_t(hash & 0x7f); }
+
+    // Groups are visited in triangular steps, which covers every group when
+    // their number is a power of two
+    class probe_sequence {
+       public:
+        probe_sequence(std::size_t hash, std::size_t capacity)
+            : mask_(capacity / group::width - 1), group_((hash >> 7) & mask_) {}
+
+        std::size_t offset() const { return group_ * group::width; }
+        void next() { group_ = (group_ + ++step_) & mask_; }
+
+       private:
+        std::size_t mask_;
+        std::size_t group_;
+        std::size_t step_ = 0;
+    };
+
+    template <typename Key>
+    iterator find_impl(const Key& key) const {
+        const auto i = find_index(key);
+        auto* self = const_cast<flat_hash_map*>(this);
+        return i == npos ? self->end() : self->iterator_at(i);
+    }
+
+    template <typename Key>
+    std::size_t erase_impl(const Key& key) {
+        const auto i = find_index(key);
+        if (i == npos) {
+            return 0;
+        }
+        erase_at(i);
+        return 1;
+    }
+
+    template <typename Key>
+    std::size_t find_index(const Key& key) const {
+        return size_ == 0 ? npos : find_index(key, hash_of(key));
+    }
+
+    template <typename Key>
+    std::size_t find_index(const Key& key, std::size_t hash) const {
+        for (probe_sequence seq(hash, capacity_);; seq.next()) {
+            const group g(ctrl_ + seq.offset());
+            for (auto mask = g.match(h2(hash)); mask; mask &= mask - 1) {
+                const auto i = seq.offset() + std::countr_zero(mask);
+                if (eq_(slots_[i].first, key)) {
+                    return i;
+                }
+            }
+            // A key is never placed beyond a group with an empty slot
+            if (g.match_empty()) {
+                return npos;
+            }
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of hash
+    std::size_t find_free(std::size_t hash) const {
+        for (probe_sequence seq(hash, capacity_);; seq.next()) {
+            const group g(ctrl_ + seq.offset());
+            if (const auto mask = g.match_empty_or_deleted()) {
+                return seq.offset() + std::countr_zero(mask);
+            }
+        }
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_impl(const K& key, Args&&... args) {
+        const auto hash = hash_of(key);
+        if (size_ != 0) {
+            if (const auto i = find_index(key, hash); i != npos) {
+                return {iterator_at(i), false};
+            }
+        }
+        auto i = capacity_ == 0 ? npos : find_free(hash);
+        if (i == npos ||
+            (growth_left_ == 0 && ctrl_[i] == detail::ctrl_empty)) {
+            grow();
+            i = find_free(hash);
+        }
+        value_traits::construct(value_alloc_, slots_ + i,
+                                std::forward<Args>(args)...);
+        if (ctrl_[i] == detail::ctrl_empty) {
+            --growth_left_;
+        }
+        ctrl_[i] = h2(hash);
+        ++size_;
+        return {iterator_at(i), true};
+    }
+
+    void erase_at(std::size_t i) {
+        value_traits::destroy(value_alloc_, slots_ + i);
+        --size_;
+        // Lookups stop at a group with an empty slot, so a slot in such a
+        // group can be freed outright; elsewhere keys may have probed past it
+        const std::size_t start = i - i % group::width;
+        if (group(ctrl_ + start).match_empty()) {
+            ctrl_[i] = detail::ctrl_empty;
+            ++growth_left_;
+        } else {
+            ctrl_[i] = detail::ctrl_deleted;
+        }
+    }
+
+    // Double the capacity, or only drop tombstones if they take up the room
+    void grow() {
+        if (capacity_ == 0) {
+            rehash(group::width);
+        } else if (size_ <= max_load(capacity_) / 2) {
+            rehash(capacity_);
+        } else {
+            rehash(capacity_ * 2);
+        }
+    }
+
+    void rehash(std::size_t capacity) {
+        ctrl_t* old_ctrl = ctrl_;
+        value_type* old_slots = slots_;
+        const std::size_t old_capacity = capacity_;
+
+        slots_ = value_traits::allocate(value_alloc_, capacity);
+        try {
+            ctrl_ = ctrl_traits::allocate(ctrl_alloc_, capacity);
+        } catch (...) {
+            value_traits::deallocate(value_alloc_, slots_, capacity);
+            slots_ = old_slots;
+            throw;
+        }
+        std::memset(ctrl_, detail::ctrl_empty, capacity);
+        capacity_ = capacity;
+        growth_left_ = max_load(capacity) - size_;
+
+        for (std::size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0) {
+                continue;
+            }
+            const auto hash = hash_of(old_slots[i].first);
+            const auto j = find_free(hash);
+            value_traits::construct(value_alloc_, slots_ + j,
+                                    std::move(old_slots[i]));
+            value_traits::destroy(value_alloc_, old_slots + i);
+            ctrl_[j] = h2(hash);
+        }
+        if (old_capacity) {
+            value_traits::deallocate(value_alloc_, old_slots, old_capacity);
+            ctrl_traits::deallocate(ctrl_alloc_, old_ctrl, old_capacity);
+        }
+    }
+
+    void destroy() noexcept {
+        if (capacity_ == 0) {
+            return;
+        }
+        clear();
+        value_traits::deallocate(value_alloc_, slots_, capacity_);
+        ctrl_traits::deallocate(ctrl_alloc_, ctrl_, capacity_);
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        growth_left_ = 0;
+    }
+
+    iterator iterator_at(std::size_t i) {
+        return {ctrl_ + i, slots_ + i, ctrl_ + capacity_};
+    }
+
+    ctrl_t* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    std::size_t growth_left_ = 0;
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual eq_;
+    [[no_unique_address]] value_allocator value_alloc_;
+    [[no_unique_address]] ctrl_allocator ctrl_alloc_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace kcu {
+
+template <typename T, auto Hook>
+class intrusive_list;
+
+// Links of an object in an intrusive_list, either as a base class of the
+// object or as a member. An object can be in as many lists at once as it has
+// hooks, and is never copied or allocated by the list.
+class intrusive_list_hook {
+    template <typename T, auto Hook>
+    friend class intrusive_list;
+
+   public:
+    intrusive_list_hook() = default;
+    // A copy of a linked object is not linked
+    intrusive_list_hook(const intrusive_list_hook&) noexcept {}
+    intrusive_list_hook& operator=(const intrusive_list_hook&) noexcept {
+        return *this;
+    }
+    // Moving a linked hook hands its place in the list over to the new
+    // hook, so objects can be relocated by a container such as
+    // flat_hash_map without being unlinked
+    intrusive_list_hook(intrusive_list_hook&& other) noexcept
+        : prev_(std::exchange(other.prev_, nullptr)),
+          next_(std::exchange(other.next_, nullptr)) {
+        if (next_) {
+            prev_->next_ = this;
+            next_->prev_ = this;
+        }
+    }
+    // Deleted rather than falling back to the copy, which would leave other
+    // linked. Taking over its place would unlink this hook behind its own
+    // list's back. Objects with a hook assign through their copy assignment.
+    intrusive_list_hook& operator=(intrusive_list_hook&&) = delete;
+
+    bool is_linked() const noexcept { return next_ != nullptr; }
+
+   private:
+    intrusive_list_hook* prev_ = nullptr;
+    intrusive_list_hook* next_ = nullptr;
+};
+
+// Doubly linked list of objects it does not own, linked through a hook:
+// intrusive_list<T> for T deriving from intrusive_list_hook, or
+// intrusive_list<T, &T::member_hook>. Insertion and removal of a given object
+// are O(1) and never allocate. Objects must be erased (or the list cleared or
+// destroyed) before they are destroyed.
+template <typename T, auto Hook = nullptr>
+class intrusive_list {
+    static constexpr bool base_hook = std::is_same_v<decltype(Hook),
+                                                     std::nullptr_t>;
+    static_assert(base_hook ||
+                      std::is_same_v<decltype(Hook), intrusive_list_hook T::*>,
+                  "Hook must be a pointer to an intrusive_list_hook member");
+
+    template <bool Const>
+    class iterator_impl {
+        friend class intrusive_list;
+
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        iterator_impl() = default;
+        operator iterator_impl<true>() const { return {hook_}; }
+
+        reference operator*() const { return owner_of(*hook_); }
+        pointer operator->() const { return &owner_of(*hook_); }
+
+        iterator_impl& operator++() {
+            hook_ = hook_->next_;
+            return *this;
+        }
+        iterator_impl operator++(int) {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+        iterator_impl& operator--() {
+            hook_ = hook_->prev_;
+            return *this;
+        }
+        iterator_impl operator--(int) {
+            auto it = *this;
+            --*this;
+            return it;
+        }
+
+        bool operator==(const iterator_impl&) const = default;
+
+       private:
+        iterator_impl(intrusive_list_hook* hook) : hook_(hook) {}
+
+        intrusive_list_hook* hook_ = nullptr;
+    };
+
+   public:
+    using value_type = T;
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    intrusive_list() noexcept {
+        head_.prev_ = &head_;
+        head_.next_ = &head_;
+    }
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list& operator=(const intrusive_list&) = delete;
+
+    ~intrusive_list() { clear(); }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& front() { return owner_of(*head_.next_); }
+    T& back() { return owner_of(*head_.prev_); }
+
+    iterator begin() noexcept { return {head_.next_}; }
+    iterator end() noexcept { return {&head_}; }
+    const_iterator begin() const noexcept {
+        return {const_cast<intrusive_list_hook*>(head_.next_)};
+    }
+    const_iterator end() const noexcept {
+        return {const_cast<intrusive_list_hook*>(&head_)};
+    }
+
+    // Iterator to an object in the list
+    iterator iterator_to(T& value) noexcept { return {&hook_of(value)}; }
+
+    void push_back(T& value) noexcept { link_before(head_, value); }
+    void push_front(T& value) noexcept { link_before(*head_.next_, value); }
+
+    // Insert value before pos
+    iterator insert(const_iterator pos, T& value) noexcept {
+        link_before(*pos.hook_, value);
+        return iterator_to(value);
+    }
+
+    void pop_front() noexcept { erase(front()); }
+    void pop_back() noexcept { erase(back()); }
+
+    // Unlink value, which must be in this list
+    iterator erase(T& value) noexcept {
+        auto& hook = hook_of(value);
+        intrusive_list_hook* next = hook.next_;
+        hook.prev_->next_ = next;
+        next->prev_ = hook.prev_;
+        hook.prev_ = nullptr;
+        hook.next_ = nullptr;
+        --size_;
+        return {next};
+    }
+
+    // Move value, which must be in this list, to the back in O(1), e.g. to
+    // mark it as most recently used
+    void move_to_back(T& value) noexcept {
+        erase(value);
+        push_back(value);
+    }
+
+    void clear() noexcept {
+        intrusive_list_hook* hook = head_.next_;
+        while (hook != &head_) {
+            intrusive_list_hook* next = hook->next_;
+            hook->prev_ = nullptr;
+            hook->next_ = nullptr;
+            hook = next;
+        }
+        head_.prev_ = &head_;
+        head_.next_ = &head_;
+        size_ = 0;
+    }
+
+   private:
+    static intrusive_list_hook& hook_of(T& value) noexcept {
+        if constexpr (base_hook) {
+            return value;
+        } else {
+            return value.*Hook;
+        }
+    }
+
+    static T& owner_of(intrusive_list_hook& hook) noexcept {
+        if constexpr (base_hook) {
+            return static_cast<T&>(hook);
+        } else {
+            // Offset of the hook member within T
+            alignas(T) static std::byte probe[sizeof(T)];
+            const T* object = reinterpret_cast<const T*>(probe);
+            const auto offset =
+                reinterpret_cast<const std::byte*>(&(object->*Hook)) - probe;
+            return *reinterpret_cast<T*>(reinterpret_cast<std::byte*>(&hook) -
+                                         offset);
+        }
+    }
+
+    void link_before(intrusive_list_hook& next, T& value) noexcept {
+        auto& hook = hook_of(value);
+        hook.prev_ = next.prev_;
+        hook.next_ = &next;
+        next.prev_->next_ = &hook;
+        next.prev_ = &hook;
+        ++size_;
+    }
+
+    intrusive_list_hook head_;
+    std::size_t size_ = 0;
+};
+
+}  // namespace kcu
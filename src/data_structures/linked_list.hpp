@@ -1,37 +1,241 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 namespace kcu {
 
-template <typename T>
+// Nodes are allocated through Allocator (rebound to the node type). With the
+// default std::allocator nodes are owned by plain std::unique_ptrs, otherwise
+// each owning pointer also carries a copy of the node allocator.
+//
+// The list keeps its size and a pointer to its last node, so push_back and
+// splice are O(1). Iterators are forward iterators in the style of
+// std::forward_list: insertion and removal happen after an iterator, and
+// before_begin() allows inserting and erasing at the front.
+template <typename T, typename Allocator = std::allocator<T>>
 class linked_list {
    public:
+    class node;
+
+   private:
+    using node_allocator = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+    static constexpr bool uses_std_allocator =
+        std::is_same_v<Allocator, std::allocator<T>>;
+
+    struct node_deleter {
+        [[no_unique_address]] node_allocator alloc;
+
+        void operator()(node* n) {
+            node_traits::destroy(alloc, n);
+            node_traits::deallocate(alloc, n, 1);
+        }
+    };
+
+   public:
+    using node_ptr =
+        std::unique_ptr<node, std::conditional_t<uses_std_allocator,
+                                                 std::default_delete<node>,
+                                                 node_deleter>>;
+
     class node final {
         friend class linked_list;
 
        public:
-        node(T&& value, std::unique_ptr<node>&& next = nullptr)
+        node(T&& value, node_ptr&& next = nullptr)
             : value_(std::forward<T>(value)), next_(std::move(next)) {}
 
+        template <typename... Args>
+        node(std::in_place_t, node_ptr&& next, Args&&... args)
+            : value_(std::forward<Args>(args)...), next_(std::move(next)) {}
+
         auto& value() const { return value_; }
         auto& next() const { return next_; }
 
        private:
         T value_;
-        std::unique_ptr<node> next_;
+        node_ptr next_;
     };
 
-    linked_list(std::unique_ptr<node>&& root) : root_(std::move(root)) {}
+   private:
+    template <bool Const>
+    class iterator_impl {
+        friend class linked_list;
+        template <bool>
+        friend class iterator_impl;
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        iterator_impl() = default;
+        operator iterator_impl<true>() const { return {node_, root_}; }
+
+        reference operator*() const { return node_->value_; }
+        pointer operator->() const { return &node_->value_; }
+
+        iterator_impl& operator++() {
+            if (root_) {
+                node_ = root_->get();
+                root_ = nullptr;
+            } else {
+                node_ = node_->next_.get();
+            }
+            return *this;
+        }
+        iterator_impl operator++(int) {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const iterator_impl&) const = default;
+
+       private:
+        iterator_impl(node* n, const node_ptr* root = nullptr)
+            : node_(n), root_(root) {}
+
+        node* node_ = nullptr;
+        // Only set on before_begin()
+        const node_ptr* root_ = nullptr;
+    };
+
+   public:
+    using value_type = T;
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    explicit linked_list(const Allocator& alloc = Allocator())
+        : root_(nullptr, deleter(alloc)), alloc_(alloc) {}
+
+    linked_list(node_ptr&& root, const Allocator& alloc = Allocator())
+        : root_(std::move(root)), alloc_(alloc) {
+        for (node* n = root_.get(); n; n = n->next_.get()) {
+            tail_ = n;
+            ++size_;
+        }
+    }
+
+    linked_list(linked_list&& other) noexcept
+        : root_(std::move(other.root_)),
+          tail_(std::exchange(other.tail_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          alloc_(other.alloc_) {}
+
+    linked_list& operator=(linked_list&& other) noexcept {
+        clear();
+        root_ = std::move(other.root_);
+        tail_ = std::exchange(other.tail_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    ~linked_list() { clear(); }
 
     auto& root() const { return root_; }
 
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& front() { return root_->value_; }
+    const T& front() const { return root_->value_; }
+    T& back() { return tail_->value_; }
+    const T& back() const { return tail_->value_; }
+
+    iterator before_begin() noexcept { return {nullptr, &root_}; }
+    const_iterator before_begin() const noexcept { return {nullptr, &root_}; }
+    iterator begin() noexcept { return {root_.get()}; }
+    const_iterator begin() const noexcept { return {root_.get()}; }
+    iterator end() noexcept { return {}; }
+    const_iterator end() const noexcept { return {}; }
+
+    // Unlink nodes one at a time, destroying the list through the chain of
+    // node_ptrs recurses once per node and overflows the stack on long lists.
+    // The head is detached before relinking so its next_ (and deleter) are
+    // still alive while being moved from.
+    void clear() noexcept {
+        while (root_) {
+            node_ptr head = std::move(root_);
+            root_ = std::move(head->next_);
+        }
+        tail_ = nullptr;
+        size_ = 0;
+    }
+
+    template <typename... Args>
+    T& emplace_front(Args&&... args) {
+        return *emplace_after(before_begin(), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        const auto pos = tail_ ? const_iterator(tail_) : before_begin();
+        return *emplace_after(pos, std::forward<Args>(args)...);
+    }
+
+    void push_front(T&& value) { emplace_front(std::forward<T>(value)); }
+    void push_back(T&& value) { emplace_back(std::forward<T>(value)); }
+
+    template <typename... Args>
+    iterator emplace_after(const_iterator pos, Args&&... args) {
+        node_ptr& link = link_after(pos);
+        auto new_node = make_node(std::in_place, std::move(link),
+                                  std::forward<Args>(args)...);
+        link = std::move(new_node);
+        if (! link->next_) {
+            tail_ = link.get();
+        }
+        ++size_;
+        return {link.get()};
+    }
+
+    iterator insert_after(const_iterator pos, T&& value) {
+        return emplace_after(pos, std::forward<T>(value));
+    }
+
+    // Erase the element after pos, returning an iterator to the element
+    // following the erased one
+    iterator erase_after(const_iterator pos) {
+        node_ptr& link = link_after(pos);
+        // Detach the node first, moving from its next_ straight into link
+        // frees it before the deleter of next_ is read
+        node_ptr erased = std::move(link);
+        link = std::move(erased->next_);
+        if (! link) {
+            tail_ = pos.root_ ? nullptr : pos.node_;
+        }
+        --size_;
+        return {link.get()};
+    }
+
+    // Move all elements of other after pos in O(1)
+    void splice_after(const_iterator pos, linked_list& other) {
+        if (other.empty()) {
+            return;
+        }
+        node_ptr& link = link_after(pos);
+        other.tail_->next_ = std::move(link);
+        if (! other.tail_->next_) {
+            tail_ = other.tail_;
+        }
+        link = std::move(other.root_);
+        size_ += std::exchange(other.size_, 0);
+        other.tail_ = nullptr;
+    }
+
     void insert(T&& value, std::size_t pos) {
         if (pos == 0) {
-            auto&& new_root = std::make_unique<node>(std::forward<T>(value),
-                                                     std::move(root_));
-            root_ = std::move(new_root);
+            push_front(std::forward<T>(value));
             return;
         }
 
@@ -40,10 +244,8 @@ class linked_list {
         for (; curr && curr->next_.get() && idx + 1 < pos; idx++) {
             curr = curr->next_.get();
         }
-        if (auto current_pos = idx + 1; idx + 1 == pos) {
-            auto&& new_node = std::make_unique<node>(std::forward<T>(value),
-                                                     std::move(curr->next_));
-            curr->next_ = std::move(new_node);
+        if (auto current_pos = idx + 1; curr && idx + 1 == pos) {
+            emplace_after(const_iterator(curr), std::forward<T>(value));
         } else {
             throw std::runtime_error(
                 "The position " + std::to_string(pos) +
@@ -53,8 +255,13 @@ class linked_list {
     }
 
     void remove(std::size_t pos) {
+        if (! root_) {
+            throw std::runtime_error("The position " + std::to_string(pos) +
+                                     " does not exist in the list. The list "
+                                     "is empty.");
+        }
         if (pos == 0) {
-            root_ = std::move(root_->next_);
+            erase_after(before_begin());
             return;
         }
 
@@ -65,10 +272,8 @@ class linked_list {
             prev = curr;
             curr = curr->next_.get();
         }
-        if (auto current_pos = idx + 1; current_pos == pos) {
-            prev->next_ = std::move(curr->next_);
-            [[maybe_unused]] auto t =
-                std::move(curr);  // make sure curr gets released.
+        if (auto current_pos = idx + 1; curr && current_pos == pos) {
+            erase_after(const_iterator(prev));
         } else {
             throw std::runtime_error(
                 "The position " + std::to_string(pos) +
@@ -78,7 +283,40 @@ class linked_list {
     }
 
    private:
-    std::unique_ptr<node> root_;
+    static auto deleter(const node_allocator& alloc) {
+        if constexpr (uses_std_allocator) {
+            return std::default_delete<node>();
+        } else {
+            return node_deleter{alloc};
+        }
+    }
+
+    // The owning pointer of the node after pos
+    node_ptr& link_after(const_iterator pos) {
+        return pos.root_ ? root_ : pos.node_->next_;
+    }
+
+    template <typename... Args>
+    node_ptr make_node(Args&&... args) {
+        if constexpr (uses_std_allocator) {
+            return std::make_unique<node>(std::forward<Args>(args)...);
+        } else {
+            node* n = node_traits::allocate(alloc_, 1);
+            try {
+                node_traits::construct(alloc_, n,
+                                       std::forward<Args>(args)...);
+            } catch (...) {
+                node_traits::deallocate(alloc_, n, 1);
+                throw;
+            }
+            return node_ptr(n, deleter(alloc_));
+        }
+    }
+
+    node_ptr root_;
+    node* tail_ = nullptr;
+    std::size_t size_ = 0;
+    [[no_unique_address]] node_allocator alloc_;
 };
 
 }  // namespace kcu
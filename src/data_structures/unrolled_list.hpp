@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace kcu {
+
+namespace detail {
+
+    // Elements per node so that a node spans about four cache lines
+    template <typename T>
+    constexpr std::size_t unrolled_node_capacity =
+        std::max<std::size_t>(4, (256 - 2 * sizeof(void*)) / sizeof(T));
+
+}  // namespace detail
+
+// Singly linked list storing up to NodeCapacity elements contiguously in each
+// node, so that traversal touches a fraction of the nodes of a linked_list and
+// walks arrays in between. Nodes are split when inserting into a full node
+// and merged with their successor when less than half full after a removal.
+// Nodes are allocated through Allocator (rebound to the node type).
+template <typename T,
+          std::size_t NodeCapacity = detail::unrolled_node_capacity<T>,
+          typename Allocator = std::allocator<T>>
+class unrolled_list {
+    static_assert(NodeCapacity >= 2, "Nodes must hold at least 2 elements");
+
+    struct node {
+        node* next = nullptr;
+        std::size_t count = 0;
+        alignas(T) std::byte storage[NodeCapacity * sizeof(T)];
+
+        T* data() { return std::launder(reinterpret_cast<T*>(storage)); }
+        T& operator[](std::size_t i) { return data()[i]; }
+    };
+
+    using node_allocator = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template <bool Const>
+    class iterator_impl {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        iterator_impl() = default;
+        iterator_impl(node* n, std::size_t i) : node_(n), idx_(i) {}
+        operator iterator_impl<true>() const { return {node_, idx_}; }
+
+        reference operator*() const { return (*node_)[idx_]; }
+        pointer operator->() const { return &(*node_)[idx_]; }
+
+        iterator_impl& operator++() {
+            if (++idx_ == node_->count) {
+                node_ = node_->next;
+                idx_ = 0;
+            }
+            return *this;
+        }
+        iterator_impl operator++(int) {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const iterator_impl&) const = default;
+
+       private:
+        node* node_ = nullptr;
+        std::size_t idx_ = 0;
+    };
+
+   public:
+    using value_type = T;
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    explicit unrolled_list(const Allocator& alloc = Allocator())
+        : alloc_(alloc) {}
+
+    unrolled_list(const unrolled_list&) = delete;
+    unrolled_list& operator=(const unrolled_list&) = delete;
+
+    unrolled_list(unrolled_list&& other) noexcept
+        : head_(std::exchange(other.head_, nullptr)),
+          tail_(std::exchange(other.tail_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          alloc_(other.alloc_) {}
+
+    ~unrolled_list() { clear(); }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& front() { return (*head_)[0]; }
+    T& back() { return (*tail_)[tail_->count - 1]; }
+
+    iterator begin() noexcept { return {head_, 0}; }
+    iterator end() noexcept { return {}; }
+    const_iterator begin() const noexcept { return {head_, 0}; }
+    const_iterator end() const noexcept { return {}; }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (! tail_ || tail_->count == NodeCapacity) {
+            node* n = make_node();
+            if (tail_) {
+                tail_->next = n;
+            } else {
+                head_ = n;
+            }
+            tail_ = n;
+        }
+        T* p = std::construct_at(tail_->data() + tail_->count,
+                                 std::forward<Args>(args)...);
+        ++tail_->count;
+        ++size_;
+        return *p;
+    }
+
+    void push_back(T&& value) { emplace_back(std::forward<T>(value)); }
+
+    void push_front(T&& value) { insert(std::forward<T>(value), 0); }
+
+    // Insert value before position pos, walking nodes rather than elements
+    void insert(T&& value, std::size_t pos) {
+        if (pos == size_) {
+            emplace_back(std::forward<T>(value));
+            return;
+        }
+        if (pos > size_) {
+            throw_out_of_range(pos, size_);
+        }
+
+        auto [n, idx] = locate(pos);
+        if (n->count == NodeCapacity) {
+            split(n);
+            if (idx > n->count) {
+                idx -= n->count;
+                n = n->next;
+            }
+        }
+        shift_up(n, idx);
+        std::construct_at(n->data() + idx, std::forward<T>(value));
+        ++n->count;
+        ++size_;
+    }
+
+    void remove(std::size_t pos) {
+        if (pos >= size_) {
+            throw_out_of_range(pos, size_ == 0 ? 0 : size_ - 1);
+        }
+
+        node* prev = nullptr;
+        node* n = head_;
+        while (pos >= n->count) {
+            pos -= n->count;
+            prev = n;
+            n = n->next;
+        }
+        std::destroy_at(n->data() + pos);
+        shift_down(n, pos);
+        --n->count;
+        --size_;
+
+        if (n->count == 0) {
+            unlink(prev, n);
+        } else if (node* next = n->next;
+                   next && n->count < NodeCapacity / 2 &&
+                   n->count + next->count <= NodeCapacity) {
+            std::uninitialized_move(next->data(), next->data() + next->count,
+                                    n->data() + n->count);
+            std::destroy(next->data(), next->data() + next->count);
+            n->count += next->count;
+            next->count = 0;
+            unlink(n, next);
+        }
+    }
+
+    // Iterative, so long lists do not overflow the stack
+    void clear() noexcept {
+        while (head_) {
+            node* next = head_->next;
+            destroy_node(head_);
+            head_ = next;
+        }
+        tail_ = nullptr;
+        size_ = 0;
+    }
+
+   private:
+    [[noreturn]] static void throw_out_of_range(std::size_t pos,
+                                                std::size_t end) {
+        throw std::runtime_error(
+            "The position " + std::to_string(pos) +
+            " does not exist in the list. The end is position " +
+            std::to_string(end) + ".");
+    }
+
+    node* make_node() {
+        node* n = node_traits::allocate(alloc_, 1);
+        return ::new (static_cast<void*>(n)) node;
+    }
+
+    void destroy_node(node* n) noexcept {
+        std::destroy(n->data(), n->data() + n->count);
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+    }
+
+    // Node and index within it of element pos < size
+    std::pair<node*, std::size_t> locate(std::size_t pos) {
+        node* n = head_;
+        while (pos >= n->count) {
+            pos -= n->count;
+            n = n->next;
+        }
+        return {n, pos};
+    }
+
+    // Move the upper half of a full node into a new node after it
+    void split(node* n) {
+        node* upper = make_node();
+        const std::size_t half = n->count / 2;
+        std::uninitialized_move(n->data() + half, n->data() + n->count,
+                                upper->data());
+        std::destroy(n->data() + half, n->data() + n->count);
+        upper->count = n->count - half;
+        n->count = half;
+        upper->next = n->next;
+        n->next = upper;
+        if (tail_ == n) {
+            tail_ = upper;
+        }
+    }
+
+    // Open a gap at idx in a node which is not full
+    void shift_up(node* n, std::size_t idx) {
+        if (idx == n->count) {
+            return;
+        }
+        T* data = n->data();
+        std::construct_at(data + n->count, std::move(data[n->count - 1]));
+        std::move_backward(data + idx, data + n->count - 1,
+                           data + n->count);
+        std::destroy_at(data + idx);
+    }
+
+    // Close the gap left by the destroyed element at idx
+    void shift_down(node* n, std::size_t idx) {
+        if (idx + 1 == n->count) {
+            return;
+        }
+        T* data = n->data();
+        std::construct_at(data + idx, std::move(data[idx + 1]));
+        std::move(data + idx + 2, data + n->count, data + idx + 1);
+        std::destroy_at(data + n->count - 1);
+    }
+
+    void unlink(node* prev, node* n) {
+        if (prev) {
+            prev->next = n->next;
+        } else {
+            head_ = n->next;
+        }
+        if (tail_ == n) {
+            tail_ = prev;
+        }
+        destroy_node(n);
+    }
+
+    node* head_ = nullptr;
+    node* tail_ = nullptr;
+    std::size_t size_ = 0;
+    [[no_unique_address]] node_allocator alloc_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,543 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "src/concurrency/future_chainer.hpp"
+#include "src/concurrency/thread_pool.hpp"
+
+namespace kcu {
+
+enum class io_backend { io_uring, thread_pool };
+
+namespace detail {
+
+    // Request in flight, referenced by its SQE's user_data and completed
+    // with the result of its CQE
+    struct io_request {
+        virtual ~io_request() = default;
+        virtual void complete(int res) = 0;
+    };
+
+    template <typename R>
+    struct io_request_impl final : io_request {
+        explicit io_request_impl(const char* what) : what(what) {}
+
+        void complete(int res) override {
+            if (res < 0) {
+                promise.set_exception(std::make_exception_ptr(
+                    std::system_error(-res, std::system_category(), what)));
+            } else if constexpr (std::is_void_v<R>) {
+                promise.set_value();
+            } else {
+                promise.set_value(R(res));
+            }
+        }
+
+        const char* what;
+        std::promise<R> promise;
+    };
+
+    // The submission and completion rings shared with the kernel, through
+    // the raw system calls. Submissions must be serialized by the caller,
+    // and completions reaped by one thread, which may wait for them while
+    // others submit.
+    class io_uring_ring {
+       public:
+        // Throws std::system_error where io_uring is unavailable, e.g.
+        // before Linux 5.1, or disabled by sysctl or seccomp
+        explicit io_uring_ring(unsigned entries) {
+            io_uring_params params{};
+            // Queue depths beyond the kernel's limit are reduced to it
+            params.flags = IORING_SETUP_CLAMP;
+            fd_ = int(::syscall(SYS_io_uring_setup, entries, &params));
+            if (fd_ < 0) {
+                throw std::system_error(errno, std::system_category(),
+                                        "io_uring_setup");
+            }
+            try {
+                map(params);
+            } catch (...) {
+                unmap();
+                ::close(fd_);
+                throw;
+            }
+        }
+
+        io_uring_ring(const io_uring_ring&) = delete;
+        io_uring_ring& operator=(const io_uring_ring&) = delete;
+
+        ~io_uring_ring() {
+            unmap();
+            ::close(fd_);
+        }
+
+        unsigned sq_entries() const noexcept { return sq_entries_; }
+        unsigned cq_entries() const noexcept { return cq_entries_; }
+
+        // Fill the next SQE with prep(sqe) and submit it. If the kernel
+        // refuses it without consuming it, the SQE is taken back out of the
+        // ring before throwing, so it is never submitted later on.
+        template <typename Prep>
+        void submit(Prep&& prep) {
+            const unsigned tail = *sq_tail_;
+            // Without SQPOLL the kernel consumes every SQE during
+            // io_uring_enter, so the ring is never full here
+            const unsigned index = tail & sq_mask_;
+            io_uring_sqe& sqe = sqes_[index];
+            sqe = io_uring_sqe{};
+            prep(sqe);
+            sq_array_[index] = index;
+            std::atomic_ref<unsigned>(*sq_tail_).store(
+                tail + 1, std::memory_order_release);
+            while (true) {
+                const int ret = enter(1, 0, 0);
+                if (ret >= 0) {
+                    return;
+                }
+                // Out of resources, or completions overflowing: wait for
+                // the reaper to make room
+                if (ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                    // Consumed anyway: its completion reports the error
+                    if (std::atomic_ref<unsigned>(*sq_head_).load(
+                            std::memory_order_acquire) != tail) {
+                        return;
+                    }
+                    std::atomic_ref<unsigned>(*sq_tail_).store(
+                        tail, std::memory_order_release);
+                    throw std::system_error(-ret, std::system_category(),
+                                            "io_uring_enter");
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // Call f(user_data, res) for each completion, waiting for one if
+        // there is none. Returns once the completions seen are consumed.
+        template <typename F>
+        void reap(F&& f) {
+            unsigned head = *cq_head_;
+            unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(
+                std::memory_order_acquire);
+            if (head == tail) {
+                enter(0, 1, IORING_ENTER_GETEVENTS);
+                tail = std::atomic_ref<unsigned>(*cq_tail_).load(
+                    std::memory_order_acquire);
+            }
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                f(cqe.user_data, cqe.res);
+            }
+            // The kernel may reuse the CQEs once the head passes them
+            std::atomic_ref<unsigned>(*cq_head_).store(
+                head, std::memory_order_release);
+        }
+
+        void register_buffers(const std::vector<iovec>& buffers) {
+            const int ret = int(::syscall(
+                SYS_io_uring_register, fd_, IORING_REGISTER_BUFFERS,
+                buffers.data(), unsigned(buffers.size())));
+            if (ret < 0) {
+                throw std::system_error(errno, std::system_category(),
+                                        "io_uring_register");
+            }
+        }
+
+        void unregister_buffers() {
+            ::syscall(SYS_io_uring_register, fd_, IORING_UNREGISTER_BUFFERS,
+                      nullptr, 0);
+        }
+
+       private:
+        int enter(unsigned to_submit, unsigned min_complete,
+                  unsigned flags) noexcept {
+            const int ret =
+                int(::syscall(SYS_io_uring_enter, fd_, to_submit,
+                              min_complete, flags, nullptr, 0));
+            return ret < 0 ? -errno : ret;
+        }
+
+        void map(const io_uring_params& params) {
+            sq_entries_ = params.sq_entries;
+            cq_entries_ = params.cq_entries;
+            sq_size_ = params.sq_off.array + sq_entries_ * sizeof(unsigned);
+            cq_size_ = params.cq_off.cqes + cq_entries_ * sizeof(io_uring_cqe);
+            // Newer kernels map both rings with one call
+            single_mmap_ = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap_) {
+                sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+            }
+            sq_ring_ = map_region(sq_size_, IORING_OFF_SQ_RING);
+            cq_ring_ = single_mmap_ ? sq_ring_
+                                    : map_region(cq_size_, IORING_OFF_CQ_RING);
+            sqes_ = static_cast<io_uring_sqe*>(map_region(
+                sq_entries_ * sizeof(io_uring_sqe), IORING_OFF_SQES));
+
+            auto* sq = static_cast<std::byte*>(sq_ring_);
+            sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask_ =
+                *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            auto* cq = static_cast<std::byte*>(cq_ring_);
+            cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask_ =
+                *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes_ =
+                reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        void* map_region(std::size_t size, off_t offset) {
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, fd_, offset);
+            if (p == MAP_FAILED) {
+                throw std::system_error(errno, std::system_category(),
+                                        "io_uring mmap");
+            }
+            return p;
+        }
+
+        void unmap() noexcept {
+            if (sqes_) {
+                ::munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+            }
+            if (cq_ring_ && ! single_mmap_) {
+                ::munmap(cq_ring_, cq_size_);
+            }
+            if (sq_ring_) {
+                ::munmap(sq_ring_, sq_size_);
+            }
+        }
+
+        int fd_ = -1;
+        unsigned sq_entries_ = 0;
+        unsigned cq_entries_ = 0;
+        std::size_t sq_size_ = 0;
+        std::size_t cq_size_ = 0;
+        bool single_mmap_ = false;
+        void* sq_ring_ = nullptr;
+        void* cq_ring_ = nullptr;
+        io_uring_sqe* sqes_ = nullptr;
+
+        unsigned* sq_head_ = nullptr;
+        unsigned* sq_tail_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned* sq_array_ = nullptr;
+        unsigned* cq_head_ = nullptr;
+        unsigned* cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe* cqes_ = nullptr;
+    };
+
+}  // namespace detail
+
+// Asynchronous file reads, writes and syncs returning kcu::futures. With
+// io_uring, a request costs one system call to queue it in the kernel's
+// submission ring rather than a blocked thread, and one reaper thread
+// completes the futures from the completion ring, so a single thread can
+// keep many reads in flight. Where io_uring is unavailable, or the
+// thread_pool backend is asked for, the same calls run pread, pwrite and
+// fsync on a thread pool.
+//
+// At most queue_depth requests are in flight; further calls block until
+// one completes. Buffers must stay valid until their future is ready.
+// Reads and writes may be short, and report the bytes transferred; errors
+// are thrown from get() as std::system_error. Continuations chained with
+// then() run on their own thread, never on the reaper. Requests in flight
+// complete before the executor is destroyed.
+class io_executor final {
+   public:
+    static constexpr unsigned fallback_threads = 4;
+
+    explicit io_executor(io_backend backend = io_backend::io_uring,
+                         unsigned queue_depth = 256)
+        : max_in_flight_(std::max(queue_depth, 1u)) {
+        if (backend == io_backend::io_uring) {
+            try {
+                ring_ = std::make_unique<detail::io_uring_ring>(
+                    max_in_flight_);
+            } catch (const std::system_error&) {
+            }
+        }
+        if (ring_) {
+            // The completion ring holds twice the submission ring's
+            // entries, so it has room for the shutdown request as well
+            max_in_flight_ =
+                std::min<std::size_t>(max_in_flight_, ring_->sq_entries());
+            reaper_ = std::thread(&io_executor::reap, this);
+        } else {
+            pool_ = std::make_unique<thread_pool<fallback_threads>>();
+        }
+    }
+
+    io_executor(const io_executor&) = delete;
+    io_executor& operator=(const io_executor&) = delete;
+
+    ~io_executor() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        if (ring_) {
+            // Wakes the reaper, which returns once nothing is in flight
+            ring_->submit([](io_uring_sqe& sqe) {
+                sqe.opcode = IORING_OP_NOP;
+            });
+            lock.unlock();
+            reaper_.join();
+            if (! buffers_.empty()) {
+                ring_->unregister_buffers();
+            }
+        } else {
+            space_.wait(lock, [this]() { return in_flight_ == 0; });
+        }
+    }
+
+    // The backend in use: io_uring unless unavailable or not asked for
+    io_backend backend() const noexcept {
+        return ring_ ? io_backend::io_uring : io_backend::thread_pool;
+    }
+
+    // Read up to buf.size() bytes at offset; 0 at end of file
+    future<std::size_t> async_read(int fd, std::span<std::byte> buf,
+                                   std::uint64_t offset) {
+        if (! ring_) {
+            return run_blocking([=]() {
+                return checked(::pread(fd, buf.data(), buf.size(),
+                                       off_t(offset)),
+                               "pread");
+            });
+        }
+        return submit<std::size_t>("io_uring read", [=](io_uring_sqe& sqe) {
+            prep_rw(sqe, IORING_OP_READ, fd, buf.data(), buf.size(), offset);
+        });
+    }
+
+    future<std::size_t> async_write(int fd, std::span<const std::byte> buf,
+                                    std::uint64_t offset) {
+        if (! ring_) {
+            return run_blocking([=]() {
+                return checked(::pwrite(fd, buf.data(), buf.size(),
+                                        off_t(offset)),
+                               "pwrite");
+            });
+        }
+        return submit<std::size_t>("io_uring write", [=](io_uring_sqe& sqe) {
+            prep_rw(sqe, IORING_OP_WRITE, fd, buf.data(), buf.size(),
+                    offset);
+        });
+    }
+
+    // Flush writes to fd to storage, its data only if data_only, as
+    // fdatasync. Writes not yet complete are not covered.
+    future<void> fsync(int fd, bool data_only = false) {
+        if (! ring_) {
+            return run_blocking([=]() {
+                if ((data_only ? ::fdatasync(fd) : ::fsync(fd)) < 0) {
+                    throw std::system_error(errno, std::system_category(),
+                                            "fsync");
+                }
+            });
+        }
+        return submit<void>("io_uring fsync", [=](io_uring_sqe& sqe) {
+            sqe.opcode = IORING_OP_FSYNC;
+            sqe.fd = fd;
+            sqe.fsync_flags = data_only ? IORING_FSYNC_DATASYNC : 0;
+        });
+    }
+
+    // Register buffers with the kernel for async_read_fixed and
+    // async_write_fixed, replacing any registered before. They are pinned
+    // once here, rather than on every request, and with a file opened
+    // O_DIRECT the device transfers to and from them without a copy.
+    // Throws std::system_error if the kernel refuses, e.g. beyond
+    // RLIMIT_MEMLOCK. Not thread-safe against fixed requests in flight.
+    void register_buffers(std::vector<std::span<std::byte>> buffers) {
+        if (ring_) {
+            std::vector<iovec> iov;
+            iov.reserve(buffers.size());
+            for (auto b : buffers) {
+                iov.push_back({b.data(), b.size()});
+            }
+            if (! buffers_.empty()) {
+                ring_->unregister_buffers();
+                buffers_.clear();
+            }
+            ring_->register_buffers(iov);
+        }
+        buffers_ = std::move(buffers);
+    }
+
+    void unregister_buffers() {
+        if (ring_ && ! buffers_.empty()) {
+            ring_->unregister_buffers();
+        }
+        buffers_.clear();
+    }
+
+    // Read into buf, which must lie within registered buffer index
+    future<std::size_t> async_read_fixed(int fd, std::span<std::byte> buf,
+                                         std::uint64_t offset,
+                                         unsigned index) {
+        check_fixed(buf.data(), buf.size(), index);
+        if (! ring_) {
+            return async_read(fd, buf, offset);
+        }
+        return submit<std::size_t>(
+            "io_uring read_fixed", [=](io_uring_sqe& sqe) {
+                prep_rw(sqe, IORING_OP_READ_FIXED, fd, buf.data(),
+                        buf.size(), offset);
+                sqe.buf_index = std::uint16_t(index);
+            });
+    }
+
+    // Write from buf, which must lie within registered buffer index
+    future<std::size_t> async_write_fixed(int fd,
+                                          std::span<const std::byte> buf,
+                                          std::uint64_t offset,
+                                          unsigned index) {
+        check_fixed(buf.data(), buf.size(), index);
+        if (! ring_) {
+            return async_write(fd, buf, offset);
+        }
+        return submit<std::size_t>(
+            "io_uring write_fixed", [=](io_uring_sqe& sqe) {
+                prep_rw(sqe, IORING_OP_WRITE_FIXED, fd, buf.data(),
+                        buf.size(), offset);
+                sqe.buf_index = std::uint16_t(index);
+            });
+    }
+
+   private:
+    static void prep_rw(io_uring_sqe& sqe, std::uint8_t opcode, int fd,
+                        const void* addr, std::size_t len,
+                        std::uint64_t offset) noexcept {
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(addr);
+        // The SQE length is 32 bits; larger spans are transferred short
+        sqe.len = unsigned(
+            std::min<std::size_t>(len, std::numeric_limits<unsigned>::max()));
+        sqe.off = offset;
+    }
+
+    static std::size_t checked(ssize_t res, const char* what) {
+        if (res < 0) {
+            throw std::system_error(errno, std::system_category(), what);
+        }
+        return std::size_t(res);
+    }
+
+    void check_fixed(const std::byte* data, std::size_t size,
+                     unsigned index) const {
+        if (index >= buffers_.size() || data < buffers_[index].data() ||
+            data + size > buffers_[index].data() + buffers_[index].size()) {
+            throw std::invalid_argument(
+                "io_executor: not within the registered buffer");
+        }
+    }
+
+    // Take a slot among the requests in flight, waiting for one if needed
+    std::unique_lock<std::mutex> acquire_slot() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [this]() { return in_flight_ < max_in_flight_; });
+        ++in_flight_;
+        return lock;
+    }
+
+    void release_slots(std::size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ -= n;
+        space_.notify_all();
+    }
+
+    template <typename R, typename Prep>
+    future<R> submit(const char* what, Prep&& prep) {
+        auto request = std::make_unique<detail::io_request_impl<R>>(what);
+        auto result = request->promise.get_future();
+        {
+            auto lock = acquire_slot();
+            try {
+                ring_->submit([&](io_uring_sqe& sqe) {
+                    prep(sqe);
+                    sqe.user_data =
+                        reinterpret_cast<std::uint64_t>(request.get());
+                });
+            } catch (...) {
+                --in_flight_;
+                throw;
+            }
+        }
+        // Owned by the ring until its completion is reaped
+        request.release();
+        return result;
+    }
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> run_blocking(F f) {
+        acquire_slot();
+        return pool_->schedule([this, f = std::move(f)]() {
+            struct release {
+                io_executor& e;
+                ~release() { e.release_slots(1); }
+            } r{*this};
+            return f();
+        });
+    }
+
+    // Reaper thread body: complete requests until stopping with none in
+    // flight
+    void reap() {
+        while (true) {
+            std::size_t completed = 0;
+            ring_->reap([&](std::uint64_t user_data, int res) {
+                // The shutdown request has no user_data
+                if (auto* request =
+                        reinterpret_cast<detail::io_request*>(user_data)) {
+                    request->complete(res);
+                    delete request;
+                    ++completed;
+                }
+            });
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (completed) {
+                in_flight_ -= completed;
+                space_.notify_all();
+            }
+            if (stopping_ && in_flight_ == 0) {
+                return;
+            }
+        }
+    }
+
+    std::unique_ptr<detail::io_uring_ring> ring_;
+    std::unique_ptr<thread_pool<fallback_threads>> pool_;
+    std::vector<std::span<std::byte>> buffers_;
+
+    std::mutex mutex_;
+    std::condition_variable space_;
+    std::size_t max_in_flight_;
+    std::size_t in_flight_ = 0;
+    bool stopping_ = false;
+    std::thread reaper_;
+};
+
+}  // namespace kcu
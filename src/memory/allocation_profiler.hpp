@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "src/concurrency/hardware_interference_size.hpp"
+
+namespace kcu {
+
+struct allocation_stats {
+    // Bucket i counts allocations of [2^(i-1), 2^i) bytes, the last bucket
+    // everything larger
+    static constexpr std::size_t histogram_buckets = 32;
+
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t live_bytes = 0;
+    // Highest bytes allocated minus deallocated by a thread, the highest of
+    // any thread (and at least live_bytes). Exact for single threaded use.
+    std::uint64_t peak_live_bytes = 0;
+    std::array<std::uint64_t, histogram_buckets> size_histogram{};
+};
+
+// Allocation counters of one type. Each thread counts into its own
+// thread_counters with plain relaxed loads and stores, merged when the stats
+// are read, so no allocation touches a cache line shared with other threads.
+// Live bytes are exact once merged; the peak is tracked per thread like
+// allocation_tracker's. When sampling is enabled 1 in sample_rate allocations
+// on each thread also records its call stack, which is the only locking path.
+class allocation_profile {
+   public:
+    static constexpr std::size_t max_stack_depth = 32;
+
+    // Padded so that threads' counters never share a cache line
+    class alignas(hardware_destructive_interference_size) thread_counters {
+       public:
+        void record_allocation(std::size_t size) noexcept {
+            increment<std::uint64_t>(allocations_, 1);
+            increment<std::uint64_t>(bytes_, size);
+            increment<std::uint64_t>(size_histogram_[bucket_of(size)], 1);
+            increment(live_bytes_, static_cast<std::int64_t>(size));
+            const auto live = live_bytes_.load(std::memory_order_relaxed);
+            if (live > peak_live_bytes_.load(std::memory_order_relaxed)) {
+                peak_live_bytes_.store(live, std::memory_order_relaxed);
+            }
+        }
+
+        void record_deallocation(std::size_t size) noexcept {
+            increment<std::uint64_t>(deallocations_, 1);
+            increment<std::uint64_t>(freed_bytes_, size);
+            // Negative when freeing objects allocated by other threads
+            increment(live_bytes_, -static_cast<std::int64_t>(size));
+        }
+
+       private:
+        friend class allocation_profile;
+
+        // Only the owning thread writes, so no read-modify-write is needed
+        template <typename U>
+        static void increment(std::atomic<U>& counter, U n) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + n,
+                          std::memory_order_relaxed);
+        }
+
+        void add_to(allocation_stats& stats) const noexcept {
+            stats.allocations += allocations_.load(std::memory_order_relaxed);
+            stats.deallocations +=
+                deallocations_.load(std::memory_order_relaxed);
+            stats.bytes += bytes_.load(std::memory_order_relaxed);
+            // Wraps back to the right total once every thread is summed
+            stats.live_bytes += bytes_.load(std::memory_order_relaxed) -
+                                freed_bytes_.load(std::memory_order_relaxed);
+            stats.peak_live_bytes = std::max<std::uint64_t>(
+                stats.peak_live_bytes,
+                peak_live_bytes_.load(std::memory_order_relaxed));
+            for (std::size_t i = 0; i < allocation_stats::histogram_buckets;
+                 ++i) {
+                stats.size_histogram[i] +=
+                    size_histogram_[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<std::uint64_t> allocations_ = 0;
+        std::atomic<std::uint64_t> deallocations_ = 0;
+        std::atomic<std::uint64_t> bytes_ = 0;
+        std::atomic<std::uint64_t> freed_bytes_ = 0;
+        std::atomic<std::int64_t> live_bytes_ = 0;
+        std::atomic<std::int64_t> peak_live_bytes_ = 0;
+        std::array<std::atomic<std::uint64_t>,
+                   allocation_stats::histogram_buckets>
+            size_histogram_{};
+        thread_counters* next_ = nullptr;
+    };
+
+    // Counters of the current thread, folded into the profile on thread exit
+    class thread_handle {
+       public:
+        explicit thread_handle(allocation_profile& profile)
+            : profile_(profile), counters_(profile.attach_thread()) {}
+        thread_handle(const thread_handle&) = delete;
+        thread_handle& operator=(const thread_handle&) = delete;
+        ~thread_handle() { profile_.detach_thread(counters_); }
+
+        thread_counters& counters() const noexcept { return *counters_; }
+
+       private:
+        allocation_profile& profile_;
+        thread_counters* counters_;
+    };
+
+    explicit allocation_profile(std::string name) : name_(std::move(name)) {
+        // Register in the list of all profiles, which is never shrunk
+        auto& head = profiles_head();
+        next_ = head.load(std::memory_order_relaxed);
+        while (! head.compare_exchange_weak(next_, this,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+    allocation_profile(const allocation_profile&) = delete;
+    allocation_profile& operator=(const allocation_profile&) = delete;
+
+    ~allocation_profile() {
+        while (threads_) {
+            auto* next = threads_->next_;
+            delete threads_;
+            threads_ = next;
+        }
+    }
+
+    const std::string& name() const noexcept { return name_; }
+
+    // 0 disables stack sampling
+    void set_sample_rate(std::uint32_t rate) noexcept {
+        sample_rate_.store(rate, std::memory_order_relaxed);
+    }
+    std::uint32_t sample_rate() const noexcept {
+        return sample_rate_.load(std::memory_order_relaxed);
+    }
+
+    // Record the call stack of a sampled allocation
+    void record_sample(std::size_t size) noexcept {
+        std::array<void*, max_stack_depth> frames;
+        const int depth = ::backtrace(frames.data(), max_stack_depth);
+        try {
+            std::lock_guard<std::mutex> lock(samples_mutex_);
+            auto& sample =
+                samples_[std::vector<void*>(frames.begin(),
+                                            frames.begin() + depth)];
+            ++sample.allocations;
+            sample.bytes += size;
+        } catch (...) {
+            // Dropping a sample is preferable to failing the allocation
+        }
+    }
+
+    allocation_stats stats() const {
+        allocation_stats stats;
+        {
+            std::lock_guard<std::mutex> lock(threads_mutex_);
+            exited_threads_.add_to(stats);
+            for (auto* t = threads_; t; t = t->next_) {
+                t->add_to(stats);
+            }
+        }
+        stats.peak_live_bytes =
+            std::max(stats.peak_live_bytes, stats.live_bytes);
+        return stats;
+    }
+
+    // Counters, non-empty histogram buckets and the sampled call stacks,
+    // heaviest first
+    void report(std::ostream& os) const {
+        const auto s = stats();
+        os << name_ << ": " << s.allocations << " allocations, "
+           << s.deallocations << " deallocations, " << s.bytes << " bytes, "
+           << s.live_bytes << " live bytes, " << s.peak_live_bytes
+           << " peak live bytes\n";
+        for (std::size_t i = 0; i < allocation_stats::histogram_buckets;
+             ++i) {
+            if (s.size_histogram[i] == 0) {
+                continue;
+            }
+            os << "  ";
+            if (i + 1 < allocation_stats::histogram_buckets) {
+                os << "< " << (std::uint64_t{1} << i);
+            } else {
+                os << ">= " << (std::uint64_t{1} << (i - 1));
+            }
+            os << " bytes: " << s.size_histogram[i] << '\n';
+        }
+
+        std::vector<std::pair<std::vector<void*>, sample>> samples;
+        {
+            std::lock_guard<std::mutex> lock(samples_mutex_);
+            samples.assign(samples_.begin(), samples_.end());
+        }
+        std::sort(samples.begin(), samples.end(),
+                  [](const auto& a, const auto& b) {
+                      return a.second.bytes > b.second.bytes;
+                  });
+        for (const auto& [frames, sample] : samples) {
+            os << "  sampled " << sample.allocations << " allocations, "
+               << sample.bytes << " bytes at\n";
+            std::unique_ptr<char*, decltype(&std::free)> symbols(
+                ::backtrace_symbols(frames.data(),
+                                    static_cast<int>(frames.size())),
+                &std::free);
+            for (std::size_t i = 0; i < frames.size(); ++i) {
+                os << "    ";
+                if (symbols) {
+                    os << symbols.get()[i];
+                } else {
+                    os << frames[i];
+                }
+                os << '\n';
+            }
+        }
+    }
+
+    // Report of every profile created so far
+    static void report_all(std::ostream& os) {
+        for (auto* p = profiles_head().load(std::memory_order_acquire); p;
+             p = p->next_) {
+            p->report(os);
+        }
+    }
+
+   private:
+    struct sample {
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    static std::atomic<allocation_profile*>& profiles_head() {
+        static std::atomic<allocation_profile*> head = nullptr;
+        return head;
+    }
+
+    static std::size_t bucket_of(std::size_t size) noexcept {
+        return std::min<std::size_t>(std::bit_width(size),
+                                     allocation_stats::histogram_buckets - 1);
+    }
+
+    thread_counters* attach_thread() {
+        auto* counters = new thread_counters;
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        counters->next_ = threads_;
+        threads_ = counters;
+        return counters;
+    }
+
+    void detach_thread(thread_counters* counters) noexcept {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        allocation_stats stats;
+        counters->add_to(stats);
+        exited_threads_.allocations_ += stats.allocations;
+        exited_threads_.deallocations_ += stats.deallocations;
+        exited_threads_.bytes_ += stats.bytes;
+        exited_threads_.freed_bytes_ += stats.bytes - stats.live_bytes;
+        if (static_cast<std::int64_t>(stats.peak_live_bytes) >
+            exited_threads_.peak_live_bytes_) {
+            exited_threads_.peak_live_bytes_ =
+                static_cast<std::int64_t>(stats.peak_live_bytes);
+        }
+        for (std::size_t i = 0; i < allocation_stats::histogram_buckets;
+             ++i) {
+            exited_threads_.size_histogram_[i] += stats.size_histogram[i];
+        }
+        for (auto** t = &threads_; *t; t = &(*t)->next_) {
+            if (*t == counters) {
+                *t = counters->next_;
+                break;
+            }
+        }
+        delete counters;
+    }
+
+    std::string name_;
+    allocation_profile* next_ = nullptr;
+    std::atomic<std::uint32_t> sample_rate_ = 0;
+
+    mutable std::mutex threads_mutex_;
+    thread_counters* threads_ = nullptr;
+    thread_counters exited_threads_;
+
+    mutable std::mutex samples_mutex_;
+    std::map<std::vector<void*>, sample> samples_;
+};
+
+// Mixin profiling the heap allocations of T, for classes which derive from it:
+// struct order : kcu::allocation_profiler<order> { ... };
+// Memory comes from the global operator new.
+template <typename T>
+class allocation_profiler {
+   public:
+    static allocation_profile& profile() {
+        static allocation_profile profile(type_name());
+        return profile;
+    }
+
+    void* operator new(std::size_t size) {
+        void* p = ::operator new(size);
+        record_allocation(size);
+        return p;
+    }
+
+    void operator delete(void* p, std::size_t size) noexcept {
+        record_deallocation(size);
+        ::operator delete(p);
+    }
+
+    void* operator new[](std::size_t size) {
+        void* p = ::operator new[](size);
+        record_allocation(size);
+        return p;
+    }
+
+    void operator delete[](void* p, std::size_t size) noexcept {
+        record_deallocation(size);
+        ::operator delete[](p);
+    }
+
+   private:
+    static allocation_profile::thread_counters& local_counters() {
+        static thread_local allocation_profile::thread_handle handle(
+            profile());
+        return handle.counters();
+    }
+
+    static void record_allocation(std::size_t size) {
+        auto& p = profile();
+        local_counters().record_allocation(size);
+        if (const auto rate = p.sample_rate(); rate != 0) {
+            static thread_local std::uint32_t countdown = 0;
+            if (countdown == 0) {
+                countdown = rate;
+                p.record_sample(size);
+            }
+            --countdown;
+        }
+    }
+
+    static void record_deallocation(std::size_t size) noexcept {
+        local_counters().record_deallocation(size);
+    }
+
+    static std::string type_name() {
+        const char* mangled = typeid(T).name();
+        int status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled(
+            abi::__cxa_demangle(mangled, nullptr, nullptr, &status),
+            &std::free);
+        return status == 0 ? demangled.get() : mangled;
+    }
+};
+
+}  // namespace kcu
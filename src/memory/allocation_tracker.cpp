@@ -0,0 +1,313 @@
+#include "src/memory/allocation_tracker.hpp"
+#include <malloc.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace kcu {
+
+namespace {
+
+    // Counters of one thread. Only the owning thread writes, other threads
+    // read them when merging the totals.
+    struct thread_counters {
+        std::atomic<std::uint64_t> allocations;
+        std::atomic<std::uint64_t> deallocations;
+        std::atomic<std::uint64_t> bytes_allocated;
+        std::atomic<std::uint64_t> bytes_deallocated;
+        std::atomic<std::int64_t> live_bytes;
+        std::atomic<std::int64_t> peak_bytes;
+        // Guarded by the registry mutex
+        bool in_use;
+        thread_counters* next;
+
+        template <typename T>
+        static void add(std::atomic<T>& counter, T n) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + n,
+                          std::memory_order_relaxed);
+        }
+
+        void reset() noexcept {
+            allocations.store(0, std::memory_order_relaxed);
+            deallocations.store(0, std::memory_order_relaxed);
+            bytes_allocated.store(0, std::memory_order_relaxed);
+            bytes_deallocated.store(0, std::memory_order_relaxed);
+            live_bytes.store(0, std::memory_order_relaxed);
+            peak_bytes.store(0, std::memory_order_relaxed);
+        }
+
+        void add_to(allocation_tracker_stats& stats) const noexcept {
+            stats.allocations += allocations.load(std::memory_order_relaxed);
+            stats.deallocations +=
+                deallocations.load(std::memory_order_relaxed);
+            stats.bytes_allocated +=
+                bytes_allocated.load(std::memory_order_relaxed);
+            stats.bytes_deallocated +=
+                bytes_deallocated.load(std::memory_order_relaxed);
+            stats.peak_bytes = std::max(
+                stats.peak_bytes, peak_bytes.load(std::memory_order_relaxed));
+        }
+    };
+
+    // Every thread's counters, plus the totals of exited threads. Counter
+    // blocks are never freed, a new thread reuses an exited thread's block.
+    // Everything here is constant initialised and trivially destructible, as
+    // operator new may be called before main and after exit.
+    struct registry {
+        std::mutex mutex;
+        thread_counters* threads = nullptr;
+        allocation_tracker_stats exited;
+    };
+
+    constinit registry threads_registry;
+
+    constinit thread_local thread_counters* local_counters = nullptr;
+    constinit thread_local bool thread_exited = false;
+    constinit thread_local bool abort_on_allocation = false;
+
+    void detach_thread() noexcept;
+
+    struct thread_exit_guard {
+        ~thread_exit_guard() { detach_thread(); }
+    };
+
+    thread_local thread_exit_guard thread_exit;
+
+    thread_counters* attach_thread() noexcept {
+        std::lock_guard<std::mutex> lock(threads_registry.mutex);
+        thread_counters* counters = threads_registry.threads;
+        while (counters && counters->in_use) {
+            counters = counters->next;
+        }
+        if (! counters) {
+            // Not operator new, which would recurse
+            counters = static_cast<thread_counters*>(
+                std::calloc(1, sizeof(thread_counters)));
+            if (! counters) {
+                return nullptr;
+            }
+            counters->next = threads_registry.threads;
+            threads_registry.threads = counters;
+        }
+        counters->in_use = true;
+        return counters;
+    }
+
+    void detach_thread() noexcept {
+        if (! local_counters) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(threads_registry.mutex);
+        local_counters->add_to(threads_registry.exited);
+        local_counters->reset();
+        local_counters->in_use = false;
+        local_counters = nullptr;
+        thread_exited = true;
+    }
+
+    thread_counters* counters_for_thread() noexcept {
+        if (! local_counters && ! thread_exited) {
+            // Registers the thread exit hook
+            [[maybe_unused]] auto* guard = &thread_exit;
+            local_counters = attach_thread();
+        }
+        return local_counters;
+    }
+
+    void record_allocation(void* p) noexcept {
+        const std::uint64_t size = ::malloc_usable_size(p);
+        if (thread_counters* c = counters_for_thread()) {
+            thread_counters::add<std::uint64_t>(c->allocations, 1);
+            thread_counters::add(c->bytes_allocated, size);
+            thread_counters::add(c->live_bytes,
+                                 static_cast<std::int64_t>(size));
+            const auto live = c->live_bytes.load(std::memory_order_relaxed);
+            if (live > c->peak_bytes.load(std::memory_order_relaxed)) {
+                c->peak_bytes.store(live, std::memory_order_relaxed);
+            }
+        } else {
+            // Thread is exiting
+            std::lock_guard<std::mutex> lock(threads_registry.mutex);
+            ++threads_registry.exited.allocations;
+            threads_registry.exited.bytes_allocated += size;
+        }
+
+        if (abort_on_allocation) {
+            abort_on_allocation = false;
+            std::fputs("kcu::no_alloc_scope: heap allocation in scope\n",
+                       stderr);
+            std::abort();
+        }
+    }
+
+    void record_deallocation(void* p) noexcept {
+        const std::uint64_t size = ::malloc_usable_size(p);
+        if (thread_counters* c = counters_for_thread()) {
+            thread_counters::add<std::uint64_t>(c->deallocations, 1);
+            thread_counters::add(c->bytes_deallocated, size);
+            thread_counters::add(c->live_bytes,
+                                 -static_cast<std::int64_t>(size));
+        } else {
+            std::lock_guard<std::mutex> lock(threads_registry.mutex);
+            ++threads_registry.exited.deallocations;
+            threads_registry.exited.bytes_deallocated += size;
+        }
+    }
+
+    void* allocate(std::size_t size, std::size_t align,
+                   bool nothrow) noexcept(false) {
+        size = std::max<std::size_t>(size, 1);
+        for (;;) {
+            void* p = nullptr;
+            if (align <= alignof(std::max_align_t)) {
+                p = std::malloc(size);
+            } else if (::posix_memalign(&p, align, size) != 0) {
+                p = nullptr;
+            }
+            if (p) {
+                record_allocation(p);
+                return p;
+            }
+
+            std::new_handler handler = std::get_new_handler();
+            if (! handler) {
+                if (nothrow) {
+                    return nullptr;
+                }
+                throw std::bad_alloc();
+            }
+            if (nothrow) {
+                try {
+                    handler();
+                } catch (...) {
+                    return nullptr;
+                }
+            } else {
+                handler();
+            }
+        }
+    }
+
+    void deallocate(void* p) noexcept {
+        if (p) {
+            record_deallocation(p);
+            std::free(p);
+        }
+    }
+
+}  // namespace
+
+namespace allocation_tracker {
+
+    allocation_tracker_stats this_thread() noexcept {
+        allocation_tracker_stats stats;
+        if (thread_counters* c = counters_for_thread()) {
+            c->add_to(stats);
+        }
+        return stats;
+    }
+
+    allocation_tracker_stats total() noexcept {
+        std::lock_guard<std::mutex> lock(threads_registry.mutex);
+        allocation_tracker_stats stats = threads_registry.exited;
+        for (auto* c = threads_registry.threads; c; c = c->next) {
+            c->add_to(stats);
+        }
+        return stats;
+    }
+
+}  // namespace allocation_tracker
+
+no_alloc_scope::no_alloc_scope(bool abort) noexcept
+    : start_(allocation_tracker::this_thread().allocations),
+      previous_abort_(abort_on_allocation) {
+    abort_on_allocation = abort_on_allocation || abort;
+}
+
+no_alloc_scope::~no_alloc_scope() { abort_on_allocation = previous_abort_; }
+
+std::uint64_t no_alloc_scope::allocations() const noexcept {
+    return allocation_tracker::this_thread().allocations - start_;
+}
+
+}  // namespace kcu
+
+void* operator new(std::size_t size) {
+    return kcu::allocate(size, 0, false);
+}
+
+void* operator new[](std::size_t size) {
+    return kcu::allocate(size, 0, false);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return kcu::allocate(size, 0, true);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return kcu::allocate(size, 0, true);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return kcu::allocate(size, static_cast<std::size_t>(align), false);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return kcu::allocate(size, static_cast<std::size_t>(align), false);
+}
+
+void* operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t&) noexcept {
+    return kcu::allocate(size, static_cast<std::size_t>(align), true);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t&) noexcept {
+    return kcu::allocate(size, static_cast<std::size_t>(align), true);
+}
+
+void operator delete(void* p) noexcept { kcu::deallocate(p); }
+
+void operator delete[](void* p) noexcept { kcu::deallocate(p); }
+
+void operator delete(void* p, std::size_t) noexcept { kcu::deallocate(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { kcu::deallocate(p); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    kcu::deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    kcu::deallocate(p);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-thread accounting of every heap allocation, by replacing the global
+// operator new and delete. Opt in by linking the kcu_allocation_tracker
+// target; the functions below are defined there.
+//
+// Each thread counts into its own counters without atomic read-modify-writes;
+// totals are merged from all threads on demand. Sizes are the usable sizes
+// reported by malloc, so may be larger than requested.
+
+namespace kcu {
+
+struct allocation_tracker_stats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes_allocated = 0;
+    std::uint64_t bytes_deallocated = 0;
+    // Highest bytes allocated minus deallocated by a thread. For totals,
+    // the highest of any thread.
+    std::int64_t peak_bytes = 0;
+
+    std::int64_t live_bytes() const {
+        return static_cast<std::int64_t>(bytes_allocated - bytes_deallocated);
+    }
+};
+
+namespace allocation_tracker {
+
+    // Counters of the calling thread
+    allocation_tracker_stats this_thread() noexcept;
+
+    // Counters of all threads, including those which have exited
+    allocation_tracker_stats total() noexcept;
+
+}  // namespace allocation_tracker
+
+// Flags heap allocations made by the current thread while in scope, to keep
+// hot paths allocation free. Either counts them, for tests to check, or
+// aborts the process on the first one. Scopes nest.
+class no_alloc_scope {
+   public:
+    explicit no_alloc_scope(bool abort_on_allocation = false) noexcept;
+    no_alloc_scope(const no_alloc_scope&) = delete;
+    no_alloc_scope& operator=(const no_alloc_scope&) = delete;
+    ~no_alloc_scope();
+
+    // Allocations made by this thread since the scope was entered
+    std::uint64_t allocations() const noexcept;
+
+   private:
+    std::uint64_t start_;
+    bool previous_abort_;
+};
+
+}  // namespace kcu
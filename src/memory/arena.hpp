@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include "src/memory/os_memory.hpp"
+
+namespace kcu {
+
+// Growable bump (monotonic) allocator for request scoped work. Memory comes
+// from a chain of chunks mapped from the OS, each twice the size of the one
+// before. Deallocation is a no-op: reset() rewinds to the first chunk in O(1)
+// and keeps every chunk for reuse, so a steady state of requests makes no
+// system calls. Optionally backs chunks with transparent huge pages.
+//
+// Usable directly, as a std::pmr::memory_resource or through arena_allocator.
+class arena final : public std::pmr::memory_resource {
+   public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    explicit arena(std::size_t initial_chunk_size = default_chunk_size,
+                   bool huge_pages = false)
+        : next_chunk_size_(huge_pages ? round_up(initial_chunk_size,
+                                                 detail::os_huge_page_size)
+                                      : initial_chunk_size),
+          huge_pages_(huge_pages) {}
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() override {
+        while (first_) {
+            chunk* next = first_->next;
+            detail::os_deallocate(first_, first_->size);
+            first_ = next;
+        }
+    }
+
+    // Release every allocation at once, keeping the chunks
+    void reset() noexcept {
+        if (first_) {
+            current_ = first_;
+            ptr_ = first_->data();
+            end_ = first_->end();
+        }
+    }
+
+    // Total size of the chunks mapped so far
+    std::size_t capacity() const noexcept {
+        std::size_t capacity = 0;
+        for (chunk* c = first_; c; c = c->next) {
+            capacity += c->size;
+        }
+        return capacity;
+    }
+
+   private:
+    struct chunk {
+        chunk* next;
+        std::size_t size;
+
+        char* data() { return reinterpret_cast<char*>(this) + header_size; }
+        char* end() { return reinterpret_cast<char*>(this) + size; }
+    };
+
+    static constexpr std::size_t header_size =
+        (sizeof(chunk) + alignof(std::max_align_t) - 1) &
+        ~(alignof(std::max_align_t) - 1);
+
+    static std::size_t round_up(std::size_t n, std::size_t a) {
+        return (n + a - 1) & ~(a - 1);
+    }
+
+    void* do_allocate(std::size_t size, std::size_t align) override {
+        auto p = (reinterpret_cast<std::uintptr_t>(ptr_) + align - 1) &
+                 ~(align - 1);
+        // Before the first chunk ptr_ and end_ are null, which a zero sized
+        // request would otherwise pass through as a null allocation
+        if (p + size > reinterpret_cast<std::uintptr_t>(end_) || ! ptr_) {
+            next_chunk(size + align);
+            p = (reinterpret_cast<std::uintptr_t>(ptr_) + align - 1) &
+                ~(align - 1);
+        }
+        ptr_ = reinterpret_cast<char*>(p + size);
+        return reinterpret_cast<void*>(p);
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    // Move to the next retained chunk if it is large enough, otherwise map a
+    // new one and link it in after the current chunk
+    void next_chunk(std::size_t size) {
+        chunk* next = current_ ? current_->next : first_;
+        if (! next || next->size - header_size < size) {
+            const std::size_t page_size = huge_pages_
+                                              ? detail::os_huge_page_size
+                                              : detail::os_page_size();
+            const std::size_t chunk_size = std::max(
+                next_chunk_size_, round_up(size + header_size, page_size));
+            next_chunk_size_ = 2 * chunk_size;
+
+            void* memory =
+                huge_pages_ ? detail::os_allocate_aligned(
+                                  chunk_size, detail::os_huge_page_size)
+                            : detail::os_allocate(chunk_size);
+            if (huge_pages_) {
+                detail::os_advise_huge_pages(memory, chunk_size);
+            }
+            chunk* c = static_cast<chunk*>(memory);
+            c->size = chunk_size;
+            c->next = next;
+            if (current_) {
+                current_->next = c;
+            } else {
+                first_ = c;
+            }
+            next = c;
+        }
+        current_ = next;
+        ptr_ = next->data();
+        end_ = next->end();
+    }
+
+    chunk* first_ = nullptr;
+    chunk* current_ = nullptr;
+    char* ptr_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t next_chunk_size_;
+    bool huge_pages_;
+};
+
+template <typename T>
+class arena_allocator {
+   public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = arena_allocator<U>;
+    };
+
+    arena_allocator(arena& arena) : arena_(&arena) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other)
+        : arena_(&other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Memory is reclaimed by arena::reset
+    void deallocate(T*, std::size_t) noexcept {}
+
+    arena& resource() const { return *arena_; }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const {
+        return arena_ == &other.resource();
+    }
+
+   private:
+    arena* arena_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "src/concurrency/hardware_interference_size.hpp"
+#include "src/memory/os_memory.hpp"
+
+namespace kcu {
+
+namespace detail {
+
+    // Shared state of a concurrent_memory_pool. Threads reference it weakly
+    // from their thread-local heap table so that a thread exiting after the
+    // pool was destroyed does not touch freed memory.
+    class concurrent_pool_state {
+       public:
+        // Power of two size classes from min_size to max_size bytes
+        static constexpr std::size_t min_size = 16;
+        static constexpr std::size_t max_size = 8192;
+        static constexpr std::size_t classes =
+            std::bit_width(max_size) - std::bit_width(min_size) + 1;
+
+        // Blocks are carved from spans aligned to their size, so the span
+        // (and its owning heap) of any block is found by masking its address
+        static constexpr std::size_t span_size = 64 * 1024;
+        static constexpr std::size_t span_header_size = 64;
+
+        // Blocks move between a heap's magazine and the central free list in
+        // batches of this many
+        static constexpr std::size_t batch_size = 32;
+
+        struct block {
+            block* next;
+            // Only set on the first block of a batch in the central list
+            block* next_batch;
+        };
+
+        struct heap;
+
+        struct span {
+            heap* owner;
+            span* next;
+        };
+
+        // Per thread allocation state. The magazines and bump regions are
+        // only touched by the owning thread, other threads only push onto
+        // the remote free lists.
+        struct alignas(hardware_destructive_interference_size) heap {
+            struct magazine {
+                block* head = nullptr;
+                std::size_t count = 0;
+            };
+
+            std::array<magazine, classes> magazines;
+            std::array<char*, classes> bump{};
+            std::array<char*, classes> bump_end{};
+            span* spans = nullptr;
+            heap* next = nullptr;
+            std::atomic<bool> in_use = true;
+            alignas(hardware_destructive_interference_size)
+                std::array<std::atomic<block*>, classes> remote_free{};
+        };
+
+        concurrent_pool_state() : id_(next_id()) {}
+        concurrent_pool_state(const concurrent_pool_state&) = delete;
+        concurrent_pool_state& operator=(const concurrent_pool_state&) =
+            delete;
+
+        ~concurrent_pool_state() {
+            heap* h = heaps_;
+            while (h) {
+                span* s = h->spans;
+                while (s) {
+                    span* next = s->next;
+                    os_deallocate(s, span_size);
+                    s = next;
+                }
+                heap* next = h->next;
+                delete h;
+                h = next;
+            }
+        }
+
+        std::uint64_t id() const noexcept { return id_; }
+
+        static std::size_t class_of(std::size_t size) noexcept {
+            return size <= min_size ? 0
+                                    : std::bit_width(size - 1) -
+                                          std::bit_width(min_size - 1);
+        }
+
+        static std::size_t class_size(std::size_t c) noexcept {
+            return min_size << c;
+        }
+
+        static span* span_of(void* p) noexcept {
+            return reinterpret_cast<span*>(reinterpret_cast<std::uintptr_t>(p) &
+                                           ~(span_size - 1));
+        }
+
+        void* allocate(heap& h, std::size_t c) {
+            auto& m = h.magazines[c];
+            if (! m.head) {
+                refill(h, c);
+            }
+            block* b = m.head;
+            m.head = b->next;
+            --m.count;
+            return b;
+        }
+
+        void deallocate(heap& h, void* p, std::size_t c) noexcept {
+            block* b = static_cast<block*>(p);
+            heap* owner = span_of(p)->owner;
+            if (owner != &h) {
+                // Hand the block back to the thread owning its span
+                auto& remote = owner->remote_free[c];
+                b->next = remote.load(std::memory_order_relaxed);
+                while (! remote.compare_exchange_weak(
+                    b->next, b, std::memory_order_release,
+                    std::memory_order_relaxed)) {
+                }
+                return;
+            }
+
+            auto& m = h.magazines[c];
+            b->next = m.head;
+            m.head = b;
+            if (++m.count > 2 * batch_size) {
+                flush_batch(m, c);
+            }
+        }
+
+        // Claim an unused heap, or create one
+        heap* acquire_heap() {
+            std::lock_guard<std::mutex> lock(heaps_mutex_);
+            for (heap* h = heaps_; h; h = h->next) {
+                bool in_use = false;
+                if (h->in_use.compare_exchange_strong(in_use, true)) {
+                    return h;
+                }
+            }
+            heap* h = new heap;
+            h->next = heaps_;
+            heaps_ = h;
+            return h;
+        }
+
+        // Return a heap whose thread has exited. Its cached blocks go to the
+        // central lists, its spans stay owned by it until another thread
+        // adopts it.
+        void release_heap(heap& h) noexcept {
+            for (std::size_t c = 0; c < classes; ++c) {
+                auto& m = h.magazines[c];
+                while (m.count >= batch_size) {
+                    flush_batch(m, c);
+                }
+                if (m.head) {
+                    push_batch(c, m.head);
+                    m = {};
+                }
+            }
+            h.in_use.store(false, std::memory_order_release);
+        }
+
+       private:
+        static std::uint64_t next_id() {
+            static std::atomic<std::uint64_t> id = 0;
+            return ++id;
+        }
+
+        void refill(heap& h, std::size_t c) {
+            auto& m = h.magazines[c];
+
+            // Blocks freed by other threads, else a batch flushed to the
+            // central list
+            block* b = h.remote_free[c].exchange(nullptr,
+                                                 std::memory_order_acquire);
+            if (! b) {
+                b = pop_batch(c);
+            }
+            if (b) {
+                m.head = b;
+                m.count = 0;
+                for (; b; b = b->next) {
+                    ++m.count;
+                }
+                return;
+            }
+
+            // Carve a batch from the current span, mapping a new one if full
+            const std::size_t size = class_size(c);
+            if (static_cast<std::size_t>(h.bump_end[c] - h.bump[c]) < size) {
+                span* s = static_cast<span*>(
+                    os_allocate_aligned(span_size, span_size));
+                s->owner = &h;
+                s->next = h.spans;
+                h.spans = s;
+                h.bump[c] = reinterpret_cast<char*>(s) + span_header_size;
+                h.bump_end[c] = reinterpret_cast<char*>(s) + span_size;
+            }
+            block* head = nullptr;
+            std::size_t count = 0;
+            for (; count < batch_size &&
+                   static_cast<std::size_t>(h.bump_end[c] - h.bump[c]) >= size;
+                 ++count) {
+                block* carved = reinterpret_cast<block*>(h.bump[c]);
+                carved->next = head;
+                head = carved;
+                h.bump[c] += size;
+            }
+            m.head = head;
+            m.count = count;
+        }
+
+        // Move batch_size blocks from the magazine to the central list
+        void flush_batch(heap::magazine& m, std::size_t c) noexcept {
+            block* head = m.head;
+            block* tail = head;
+            for (std::size_t i = 1; i < batch_size; ++i) {
+                tail = tail->next;
+            }
+            m.head = tail->next;
+            m.count -= batch_size;
+            tail->next = nullptr;
+            push_batch(c, head);
+        }
+
+        void push_batch(std::size_t c, block* batch) noexcept {
+            std::lock_guard<std::mutex> lock(central_[c].mutex);
+            batch->next_batch = central_[c].batches;
+            central_[c].batches = batch;
+        }
+
+        block* pop_batch(std::size_t c) noexcept {
+            std::lock_guard<std::mutex> lock(central_[c].mutex);
+            block* batch = central_[c].batches;
+            if (batch) {
+                central_[c].batches = batch->next_batch;
+            }
+            return batch;
+        }
+
+        struct alignas(hardware_destructive_interference_size) central_list {
+            std::mutex mutex;
+            block* batches = nullptr;
+        };
+
+        std::uint64_t id_;
+        std::array<central_list, classes> central_;
+        std::mutex heaps_mutex_;
+        heap* heaps_ = nullptr;
+    };
+
+}  // namespace detail
+
+// Thread-safe pool for allocations of up to max_size bytes, tcache style:
+// each thread allocates from its own heap with magazines of free blocks per
+// size class, exchanged in batches with central free lists when they run dry
+// or overflow. A block freed by another thread than the one owning its span
+// is pushed onto the owner's lock-free remote free list, which the owner
+// drains when its magazine is empty. Larger allocations go to operator new.
+class concurrent_memory_pool {
+    using state = detail::concurrent_pool_state;
+
+   public:
+    static constexpr std::size_t max_size = state::max_size;
+
+    concurrent_memory_pool() : state_(std::make_shared<state>()) {}
+    concurrent_memory_pool(const concurrent_memory_pool&) = delete;
+    concurrent_memory_pool& operator=(const concurrent_memory_pool&) = delete;
+
+    void* allocate(std::size_t size) {
+        if (size > max_size) {
+            return ::operator new(size);
+        }
+        return state_->allocate(local_heap(), state::class_of(size));
+    }
+
+    void deallocate(void* p, std::size_t size) noexcept {
+        if (! p) {
+            return;
+        }
+        if (size > max_size) {
+            ::operator delete(p);
+            return;
+        }
+        state_->deallocate(local_heap(), p, state::class_of(size));
+    }
+
+   private:
+    // Heaps this thread uses, one per pool, released when the thread exits
+    struct thread_heaps {
+        struct entry {
+            std::uint64_t pool_id;
+            state::heap* heap;
+            std::weak_ptr<state> pool;
+        };
+
+        ~thread_heaps() {
+            for (auto& e : entries) {
+                if (auto pool = e.pool.lock()) {
+                    pool->release_heap(*e.heap);
+                }
+            }
+        }
+
+        std::vector<entry> entries;
+        // Most recently used entry
+        std::uint64_t last_pool_id = 0;
+        state::heap* last_heap = nullptr;
+    };
+
+    state::heap& local_heap() {
+        static thread_local thread_heaps heaps;
+        if (heaps.last_pool_id == state_->id()) {
+            return *heaps.last_heap;
+        }
+
+        state::heap* heap = nullptr;
+        std::erase_if(heaps.entries, [&](const thread_heaps::entry& e) {
+            if (e.pool_id == state_->id()) {
+                heap = e.heap;
+            }
+            return e.pool.expired();
+        });
+        if (! heap) {
+            heap = state_->acquire_heap();
+            heaps.entries.push_back({state_->id(), heap, state_});
+        }
+        heaps.last_pool_id = state_->id();
+        heaps.last_heap = heap;
+        return *heap;
+    }
+
+    std::shared_ptr<state> state_;
+};
+
+template <typename T>
+class concurrent_pool_allocator {
+   public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = concurrent_pool_allocator<U>;
+    };
+
+    concurrent_pool_allocator(concurrent_memory_pool& memory_pool)
+        : memory_pool_(&memory_pool) {}
+
+    template <typename U>
+    concurrent_pool_allocator(const concurrent_pool_allocator<U>& other)
+        : memory_pool_(&other.pool()) {}
+
+    T* allocate(std::size_t n) {
+        static_assert(alignof(T) <= 16, "Over-aligned types are unsupported");
+        return static_cast<T*>(memory_pool_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        memory_pool_->deallocate(p, n * sizeof(T));
+    }
+
+    concurrent_memory_pool& pool() const { return *memory_pool_; }
+
+    template <typename U>
+    bool operator==(const concurrent_pool_allocator<U>& other) const {
+        return memory_pool_ == &other.pool();
+    }
+
+   private:
+    concurrent_memory_pool* memory_pool_;
+};
+
+}  // namespace kcu
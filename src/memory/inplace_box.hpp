@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kcu {
+
+// Owning handle to an object of T or a class derived from it, like a
+// unique_ptr<T>, which stores objects of up to Size bytes inline rather than
+// on the heap. Larger objects, over-aligned ones, and ones which may throw
+// when moved are allocated and the handle holds a pointer to them. Holding
+// small polymorphic objects by value saves their allocation and the cache
+// miss of following the pointer.
+//
+// Moving an inline object moves it into the destination handle's storage.
+template <typename T, std::size_t Size = 3 * sizeof(void*),
+          std::size_t Align = alignof(void*)>
+class inplace_box final {
+    static_assert(Size >= sizeof(void*) && Align >= alignof(void*),
+                  "Storage must at least hold a pointer");
+
+    template <typename U>
+    static constexpr bool fits_inline =
+        sizeof(U) <= Size && alignof(U) <= Align &&
+        std::is_nothrow_move_constructible_v<U>;
+
+    // Type erased operations on the stored object
+    struct ops {
+        T* (*get)(void* storage) noexcept;
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        bool is_inline;
+    };
+
+    template <typename U>
+    static constexpr ops inline_ops = {
+        [](void* storage) noexcept -> T* {
+            return std::launder(static_cast<U*>(storage));
+        },
+        [](void* dst, void* src) noexcept {
+            U* u = std::launder(static_cast<U*>(src));
+            ::new (dst) U(std::move(*u));
+            u->~U();
+        },
+        [](void* storage) noexcept {
+            std::launder(static_cast<U*>(storage))->~U();
+        },
+        true,
+    };
+
+    template <typename U>
+    static constexpr ops heap_ops = {
+        [](void* storage) noexcept -> T* {
+            return *std::launder(static_cast<U**>(storage));
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) U*(*std::launder(static_cast<U**>(src)));
+        },
+        [](void* storage) noexcept {
+            delete *std::launder(static_cast<U**>(storage));
+        },
+        false,
+    };
+
+   public:
+    inplace_box() noexcept = default;
+
+    template <typename U, typename... Args>
+        requires std::is_base_of_v<T, U>
+    explicit inplace_box(std::in_place_type_t<U>, Args&&... args) {
+        construct<U>(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+        requires(std::is_base_of_v<T, std::remove_cvref_t<U>> &&
+                 ! std::is_same_v<std::remove_cvref_t<U>, inplace_box>)
+    inplace_box(U&& value) {
+        construct<std::remove_cvref_t<U>>(std::forward<U>(value));
+    }
+
+    inplace_box(inplace_box&& other) noexcept { take(other); }
+
+    inplace_box& operator=(inplace_box&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    inplace_box(const inplace_box&) = delete;
+    inplace_box& operator=(const inplace_box&) = delete;
+
+    ~inplace_box() { reset(); }
+
+    // Destroy the current object, if any, and construct a U in its place
+    template <typename U, typename... Args>
+        requires std::is_base_of_v<T, U>
+    U& emplace(Args&&... args) {
+        reset();
+        construct<U>(std::forward<Args>(args)...);
+        return static_cast<U&>(*ptr_);
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+            ptr_ = nullptr;
+        }
+    }
+
+    // Whether the object is stored in the handle rather than on the heap
+    bool is_inline() const noexcept { return ops_ && ops_->is_inline; }
+
+    T* get() const noexcept { return ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    explicit operator bool() const noexcept { return ptr_; }
+
+   private:
+    template <typename U, typename... Args>
+    void construct(Args&&... args) {
+        if constexpr (fits_inline<U>) {
+            ::new (static_cast<void*>(storage_)) U(std::forward<Args>(args)...);
+            ops_ = &inline_ops<U>;
+        } else {
+            ::new (static_cast<void*>(storage_))
+                U*(new U(std::forward<Args>(args)...));
+            ops_ = &heap_ops<U>;
+        }
+        // The T subobject may not be at the start of a U, so the pointer is
+        // kept rather than recomputed on every access
+        ptr_ = ops_->get(storage_);
+    }
+
+    void take(inplace_box& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+            ptr_ = ops_->get(storage_);
+            other.ptr_ = nullptr;
+        }
+    }
+
+    T* ptr_ = nullptr;
+    const ops* ops_ = nullptr;
+    alignas(Align) std::byte storage_[Size];
+};
+
+template <typename T, typename U = T, std::size_t Size = 3 * sizeof(void*),
+          typename... Args>
+inplace_box<T, Size> make_inplace_box(Args&&... args) {
+    return inplace_box<T, Size>(std::in_place_type<U>,
+                                std::forward<Args>(args)...);
+}
+
+}  // namespace kcu
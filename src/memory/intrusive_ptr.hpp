@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace kcu {
+
+enum class ref_counting {
+    // Copies may be made and dropped from any thread
+    atomic,
+    // All copies stay on one thread, counted with plain increments
+    non_atomic
+};
+
+// Base class embedding the reference count of objects held by intrusive_ptr:
+// struct order : kcu::intrusive_ref_counter<order> { ... };
+// The object and its count are one allocation, and the count lives next to
+// the data, so a copy touches a cache line the holder usually reads anyway.
+// There are no weak references. The last intrusive_ptr deletes the object as
+// a Derived.
+template <typename Derived, ref_counting Counting = ref_counting::atomic>
+class intrusive_ref_counter {
+    using count_t =
+        std::conditional_t<Counting == ref_counting::atomic,
+                           std::atomic<std::uint32_t>, std::uint32_t>;
+
+   public:
+    std::uint32_t use_count() const noexcept {
+        if constexpr (Counting == ref_counting::atomic) {
+            return count_.load(std::memory_order_relaxed);
+        } else {
+            return count_;
+        }
+    }
+
+    friend void intrusive_ptr_add_ref(const intrusive_ref_counter* p) noexcept {
+        if constexpr (Counting == ref_counting::atomic) {
+            p->count_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++p->count_;
+        }
+    }
+
+    friend void intrusive_ptr_release(const intrusive_ref_counter* p) noexcept {
+        if constexpr (Counting == ref_counting::atomic) {
+            // Writes through other references happen before the deletion
+            if (p->count_.fetch_sub(1, std::memory_order_release) == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                delete static_cast<const Derived*>(p);
+            }
+        } else if (--p->count_ == 0) {
+            delete static_cast<const Derived*>(p);
+        }
+    }
+
+   protected:
+    intrusive_ref_counter() noexcept = default;
+    // A copy of an object is a new object, with no references yet
+    intrusive_ref_counter(const intrusive_ref_counter&) noexcept {}
+    intrusive_ref_counter& operator=(const intrusive_ref_counter&) noexcept {
+        return *this;
+    }
+    ~intrusive_ref_counter() = default;
+
+   private:
+    mutable count_t count_ = 0;
+};
+
+// Shared ownership of an object counting its own references, through the
+// functions intrusive_ptr_add_ref(T*) and intrusive_ptr_release(T*) found by
+// argument dependent lookup, e.g. those of intrusive_ref_counter. The
+// pointer is a single T*, so copying it is one increment, without the
+// separate control block of std::shared_ptr.
+template <typename T>
+class intrusive_ptr final {
+   public:
+    using element_type = T;
+
+    constexpr intrusive_ptr() noexcept = default;
+    constexpr intrusive_ptr(std::nullptr_t) noexcept {}
+
+    // Takes a reference to p, or adopts one already taken if add_ref is false
+    explicit intrusive_ptr(T* p, bool add_ref = true) noexcept : ptr_(p) {
+        if (ptr_ && add_ref) {
+            intrusive_ptr_add_ref(ptr_);
+        }
+    }
+
+    intrusive_ptr(const intrusive_ptr& other) noexcept
+        : intrusive_ptr(other.ptr_) {}
+
+    intrusive_ptr(intrusive_ptr&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+    // From a pointer to a derived class
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    intrusive_ptr(const intrusive_ptr<U>& other) noexcept
+        : intrusive_ptr(other.get()) {}
+
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    intrusive_ptr(intrusive_ptr<U>&& other) noexcept
+        : ptr_(other.detach()) {}
+
+    intrusive_ptr& operator=(intrusive_ptr other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~intrusive_ptr() {
+        if (ptr_) {
+            intrusive_ptr_release(ptr_);
+        }
+    }
+
+    void swap(intrusive_ptr& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    void reset() noexcept { intrusive_ptr().swap(*this); }
+    void reset(T* p, bool add_ref = true) noexcept {
+        intrusive_ptr(p, add_ref).swap(*this);
+    }
+
+    // Give up the reference without releasing it
+    T* detach() noexcept { return std::exchange(ptr_, nullptr); }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_; }
+
+   private:
+    T* ptr_ = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) {
+    return a.get() == b.get();
+}
+
+template <typename T>
+bool operator==(const intrusive_ptr<T>& p, std::nullptr_t) {
+    return ! p;
+}
+
+template <typename T, typename... Args>
+intrusive_ptr<T> make_intrusive(Args&&... args) {
+    return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+}  // namespace kcu
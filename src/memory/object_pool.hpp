@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "src/memory/os_memory.hpp"
+
+namespace kcu {
+
+class object_pool_resource;
+
+namespace detail {
+
+    // Slab allocator for slots of one size. Slabs are mapped from the OS,
+    // doubling in size up to max_slab_size, and are carved into slots lazily.
+    // Free slots are chained through their own storage, so there is no per
+    // slot header.
+    class slab_pool {
+       public:
+        static constexpr std::size_t min_slab_size = 64 * 1024;
+        static constexpr std::size_t max_slab_size = 4 * 1024 * 1024;
+
+        slab_pool(std::size_t size, std::size_t align,
+                  object_pool_resource* owner = nullptr)
+            : slot_align_(std::max(align, alignof(slot))),
+              slot_size_(round_up(std::max(size, sizeof(slot)), slot_align_)),
+              next_slab_size_(min_slab_size),
+              owner_(owner) {}
+
+        slab_pool(const slab_pool&) = delete;
+        slab_pool& operator=(const slab_pool&) = delete;
+
+        ~slab_pool() {
+            while (slabs_) {
+                slab* next = slabs_->next;
+                os_deallocate(slabs_, slabs_->size);
+                slabs_ = next;
+            }
+        }
+
+        void* allocate() {
+            if (free_list_) {
+                slot* s = free_list_;
+                free_list_ = s->next;
+                return s;
+            }
+            if (bump_ + slot_size_ > bump_end_) {
+                grow();
+            }
+            void* p = bump_;
+            bump_ += slot_size_;
+            return p;
+        }
+
+        void deallocate(void* p) noexcept {
+            slot* s = static_cast<slot*>(p);
+            s->next = free_list_;
+            free_list_ = s;
+        }
+
+        std::size_t slot_size() const noexcept { return slot_size_; }
+        std::size_t slot_align() const noexcept { return slot_align_; }
+        object_pool_resource* owner() const noexcept { return owner_; }
+
+       private:
+        struct slot {
+            slot* next;
+        };
+
+        struct slab {
+            slab* next;
+            std::size_t size;
+        };
+
+        static std::size_t round_up(std::size_t n, std::size_t a) {
+            return (n + a - 1) / a * a;
+        }
+
+        void grow() {
+            const std::size_t header = round_up(sizeof(slab), slot_align_);
+            std::size_t size = next_slab_size_;
+            while (size < header + slot_size_) {
+                size *= 2;
+            }
+            next_slab_size_ = std::min(2 * next_slab_size_, max_slab_size);
+
+            slab* s = static_cast<slab*>(os_allocate(size));
+            s->next = slabs_;
+            s->size = size;
+            slabs_ = s;
+            bump_ = reinterpret_cast<char*>(s) + header;
+            bump_end_ = reinterpret_cast<char*>(s) + size;
+        }
+
+        std::size_t slot_align_;
+        std::size_t slot_size_;
+        std::size_t next_slab_size_;
+        object_pool_resource* owner_;
+        slot* free_list_ = nullptr;
+        slab* slabs_ = nullptr;
+        char* bump_ = nullptr;
+        char* bump_end_ = nullptr;
+    };
+
+}  // namespace detail
+
+// Pool of fixed size slots for objects of type T. allocate and deallocate are
+// a pointer pop and push. Memory is only returned to the OS when the pool is
+// destroyed, and live objects are not destroyed with it.
+template <typename T>
+class object_pool {
+   public:
+    object_pool() : pool_(sizeof(T), alignof(T)) {}
+
+    T* allocate() { return static_cast<T*>(pool_.allocate()); }
+    void deallocate(T* p) noexcept { pool_.deallocate(p); }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        T* p = allocate();
+        try {
+            return new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(p);
+            throw;
+        }
+    }
+
+    void destroy(T* p) noexcept(std::is_nothrow_destructible_v<T>) {
+        p->~T();
+        deallocate(p);
+    }
+
+   private:
+    detail::slab_pool pool_;
+};
+
+// Set of slab pools, one per slot size and alignment, shared by the
+// object_pool_allocators of all types rebound from one another
+class object_pool_resource {
+   public:
+    object_pool_resource() = default;
+    object_pool_resource(const object_pool_resource&) = delete;
+    object_pool_resource& operator=(const object_pool_resource&) = delete;
+
+    detail::slab_pool& pool_for(std::size_t size, std::size_t align) {
+        for (auto& [pool_size, pool_align, pool] : pools_) {
+            if (pool_size == size && pool_align == align) {
+                return *pool;
+            }
+        }
+        auto pool = std::make_unique<detail::slab_pool>(size, align, this);
+        return *std::get<2>(pools_.emplace_back(size, align, std::move(pool)));
+    }
+
+   private:
+    std::vector<std::tuple<std::size_t, std::size_t,
+                           std::unique_ptr<detail::slab_pool>>>
+        pools_;
+};
+
+// STL compatible allocator using an object_pool_resource. Single object
+// allocations (the nodes of std::list, std::map and kcu::linked_list) come
+// from the slab pool for T; array allocations fall back to operator new.
+template <typename T>
+class object_pool_allocator {
+   public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = object_pool_allocator<U>;
+    };
+
+    object_pool_allocator(object_pool_resource& resource)
+        : pool_(&resource.pool_for(sizeof(T), alignof(T))) {}
+
+    template <typename U>
+    object_pool_allocator(const object_pool_allocator<U>& other)
+        : object_pool_allocator(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(pool_->allocate());
+        }
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1) {
+            pool_->deallocate(p);
+        } else {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+    }
+
+    object_pool_resource& resource() const { return *pool_->owner(); }
+
+    template <typename U>
+    bool operator==(const object_pool_allocator<U>& other) const {
+        return &resource() == &other.resource();
+    }
+
+   private:
+    detail::slab_pool* pool_;
+};
+
+}  // namespace kcu
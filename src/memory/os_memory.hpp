@@ -0,0 +1,65 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace kcu {
+
+namespace detail {
+
+    inline std::size_t os_page_size() noexcept {
+        static const std::size_t page_size =
+            static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return page_size;
+    }
+
+    // Map size bytes of zeroed, page aligned memory directly from the OS
+    inline void* os_allocate(std::size_t size) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    inline void os_deallocate(void* p, std::size_t size) noexcept {
+        ::munmap(p, size);
+    }
+
+    // Size of a transparent huge page on x86-64 and most arm64 kernels
+    inline constexpr std::size_t os_huge_page_size = 2 * 1024 * 1024;
+
+    // Ask for the range to be backed by transparent huge pages. Only a hint:
+    // it is silently ignored if the kernel has them disabled.
+    inline void os_advise_huge_pages(void* p, std::size_t size) noexcept {
+#ifdef MADV_HUGEPAGE
+        ::madvise(p, size, MADV_HUGEPAGE);
+#else
+        (void)p;
+        (void)size;
+#endif
+    }
+
+    // As os_allocate, aligned to align (a power of two multiple of the page
+    // size) by over-mapping and unmapping the excess on either side
+    inline void* os_allocate_aligned(std::size_t size, std::size_t align) {
+        char* p = static_cast<char*>(os_allocate(size + align));
+        const std::size_t misalignment =
+            reinterpret_cast<std::uintptr_t>(p) & (align - 1);
+        const std::size_t head = misalignment ? align - misalignment : 0;
+        if (head) {
+            os_deallocate(p, head);
+        }
+        if (const std::size_t tail = align - head; tail) {
+            os_deallocate(p + head + size, tail);
+        }
+        return p + head;
+    }
+
+}  // namespace detail
+
+}  // namespace kcu
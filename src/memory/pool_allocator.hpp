@@ -1,35 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <new>
+#include <utility>
 
 namespace kcu {
 
+// Fixed-size memory pool using segregated free lists with O(1) allocate and
+// deallocate (a two-level segregated fit allocator).
+//
+// Every block starts with a header storing its size and the size of the
+// physically preceding block, so that on deallocation a block is coalesced
+// with its free neighbours in constant time. Free blocks are kept in lists
+// indexed by size class: the first level is the power of two of the size, the
+// second level splits each power of two into sub_classes linear ranges.
+// Bitmaps of the non-empty lists locate a large enough block with two bit
+// scans.
 template <std::size_t PoolSize>
 class memory_pool {
    public:
+    // All blocks (and so all allocations) are aligned to this
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+
     memory_pool() {
-        static_assert(PoolSize >= sizeof(block),
+        static_assert(PoolSize >= header_size + min_block_size + header_size,
                       "Pool size must be large enough for at least one block");
         initialize_memory_pool();
     }
 
+    memory_pool(const memory_pool&) = delete;
+    memory_pool& operator=(const memory_pool&) = delete;
     ~memory_pool() = default;
 
-    void* allocate(std::size_t size) {
-        if (size == 0 || size > pool_size_) {
+    void* allocate(std::size_t size, std::size_t align = alignment) {
+        if (size == 0 || size > PoolSize || ! std::has_single_bit(align)) {
             throw std::bad_alloc();
         }
 
-        if (! free_list_ || size + sizeof(block) > free_list_->size) {
-            return allocate_new_block(size);
+        const std::size_t request = block_size_for(size);
+        if (align <= alignment) {
+            block* b = take_free_block(request);
+            return use(b, request);
         }
 
-        block* allocated_block = free_list_;
-
-        free_list_ = free_list_->next;
-
-        return reinterpret_cast<void*>(
-            reinterpret_cast<char*>(allocated_block) + sizeof(block));
+        // Over-aligned: take a block with enough slack to split off a free
+        // block in front of the aligned payload
+        block* b = take_free_block(request + align + min_block_size);
+        const auto payload = reinterpret_cast<std::uintptr_t>(payload_of(b));
+        auto aligned = (payload + align - 1) & ~(align - 1);
+        if (aligned != payload && aligned - payload < min_block_size) {
+            aligned = (payload + min_block_size + align - 1) & ~(align - 1);
+        }
+        if (const std::size_t gap = aligned - payload; gap != 0) {
+            block* aligned_block = split(b, gap);
+            insert_free_block(b);
+            b = aligned_block;
+        }
+        return use(b, request);
     }
 
     void deallocate(void* ptr) {
@@ -37,55 +70,211 @@ class memory_pool {
             return;
         }
 
-        block* deallocated_block = reinterpret_cast<block*>(
-            reinterpret_cast<char*>(ptr) - sizeof(block));
+        block* b = reinterpret_cast<block*>(static_cast<char*>(ptr) -
+                                            header_size);
+        b->size &= ~free_bit;
 
-        // Add the deallocated block back to the free list
-        deallocated_block->next = free_list_;
-        free_list_ = deallocated_block;
+        // Coalesce with the physically adjacent free blocks
+        if (b->prev_size != 0) {
+            if (block* prev = prev_block(b); is_free(prev)) {
+                remove_free_block(prev);
+                b = merge(prev, b);
+            }
+        }
+        if (block* next = next_block(b); is_free(next)) {
+            remove_free_block(next);
+            b = merge(b, next);
+        }
+        insert_free_block(b);
     }
 
    private:
     struct block {
+        // Size of the physically preceding block, 0 for the first block
+        std::size_t prev_size;
+        // Size of this block including its header, low bit set when free
         std::size_t size;
-        block* next;
+        // Only valid while the block is free, stored in the payload
+        block* next_free;
+        block* prev_free;
     };
 
+    static constexpr std::size_t round_up(std::size_t n, std::size_t a) {
+        return (n + a - 1) & ~(a - 1);
+    }
+
+    static constexpr std::size_t free_bit = 1;
+    static constexpr std::size_t header_size =
+        round_up(offsetof(block, next_free), alignment);
+    static constexpr std::size_t min_block_size =
+        round_up(sizeof(block), alignment);
+
+    // Size classes: sizes below small_block_size map linearly onto first
+    // level 0, above that each power of two is split into sub_classes ranges
+    static constexpr std::size_t sub_class_bits = 4;
+    static constexpr std::size_t sub_classes = 1 << sub_class_bits;
+    static constexpr std::size_t small_block_size = sub_classes * alignment;
+    static constexpr std::size_t small_block_shift =
+        std::bit_width(small_block_size) - 1;
+    static constexpr std::size_t classes =
+        std::max<std::size_t>(std::bit_width(PoolSize), small_block_shift) -
+        small_block_shift + 1;
+
     alignas(alignof(std::max_align_t)) char memory_pool_[PoolSize];
-    block* free_list_;
-    std::size_t pool_size_;
-    std::size_t
-        offset_;  // Keep track of the offset within the fixed-size array
+    std::uint64_t class_bitmap_;
+    std::array<std::uint32_t, classes> sub_class_bitmaps_;
+    std::array<std::array<block*, sub_classes>, classes> free_lists_;
+
+    static std::size_t block_size_for(std::size_t size) {
+        return std::max(round_up(size + header_size, alignment),
+                        min_block_size);
+    }
+
+    static bool is_free(const block* b) { return b->size & free_bit; }
+    static std::size_t size_of(const block* b) { return b->size & ~free_bit; }
+
+    static void* payload_of(block* b) {
+        return reinterpret_cast<char*>(b) + header_size;
+    }
+
+    static block* next_block(block* b) {
+        return reinterpret_cast<block*>(reinterpret_cast<char*>(b) +
+                                        size_of(b));
+    }
+
+    static block* prev_block(block* b) {
+        return reinterpret_cast<block*>(reinterpret_cast<char*>(b) -
+                                        b->prev_size);
+    }
+
+    // Size class whose range contains size
+    static std::pair<std::size_t, std::size_t> class_of(std::size_t size) {
+        if (size < small_block_size) {
+            return {0, size / alignment};
+        }
+        const std::size_t log2 = std::bit_width(size) - 1;
+        return {log2 - small_block_shift + 1,
+                (size >> (log2 - sub_class_bits)) - sub_classes};
+    }
+
+    // Smallest size class whose blocks are all at least size
+    static std::pair<std::size_t, std::size_t> class_at_least(
+        std::size_t size) {
+        if (size >= small_block_size) {
+            const std::size_t log2 = std::bit_width(size) - 1;
+            size += (std::size_t{1} << (log2 - sub_class_bits)) - 1;
+        }
+        return class_of(size);
+    }
 
     void initialize_memory_pool() {
+        class_bitmap_ = 0;
+        sub_class_bitmaps_.fill(0);
+        for (auto& lists : free_lists_) {
+            lists.fill(nullptr);
+        }
+
+        // One free block spanning the pool, followed by a used sentinel
+        // header which stops coalescing past the end
+        const std::size_t size = (PoolSize - header_size) & ~(alignment - 1);
         block* initial_block = reinterpret_cast<block*>(memory_pool_);
-        initial_block->size = PoolSize - sizeof(block);
-        initial_block->next = nullptr;
-        free_list_ = initial_block;
-        pool_size_ = PoolSize;
-        offset_ = 0;
+        initial_block->prev_size = 0;
+        initial_block->size = size;
+        block* sentinel = next_block(initial_block);
+        sentinel->prev_size = size;
+        sentinel->size = 0;
+        insert_free_block(initial_block);
     }
 
-    void* allocate_new_block(std::size_t size) {
-        std::size_t block_size = size + sizeof(block);
+    void insert_free_block(block* b) {
+        b->size |= free_bit;
+        const auto [c, s] = class_of(size_of(b));
+        b->prev_free = nullptr;
+        b->next_free = free_lists_[c][s];
+        if (b->next_free) {
+            b->next_free->prev_free = b;
+        }
+        free_lists_[c][s] = b;
+        class_bitmap_ |= std::uint64_t{1} << c;
+        sub_class_bitmaps_[c] |= std::uint32_t{1} << s;
+    }
 
-        if (block_size > pool_size_) {
+    void remove_free_block(block* b) {
+        const auto [c, s] = class_of(size_of(b));
+        if (b->next_free) {
+            b->next_free->prev_free = b->prev_free;
+        }
+        if (b->prev_free) {
+            b->prev_free->next_free = b->next_free;
+        } else {
+            free_lists_[c][s] = b->next_free;
+            if (! free_lists_[c][s]) {
+                sub_class_bitmaps_[c] &= ~(std::uint32_t{1} << s);
+                if (! sub_class_bitmaps_[c]) {
+                    class_bitmap_ &= ~(std::uint64_t{1} << c);
+                }
+            }
+        }
+        b->size &= ~free_bit;
+    }
+
+    // Remove and return a free block of at least size bytes
+    block* take_free_block(std::size_t size) {
+        // The head of the list containing size often fits, which keeps
+        // recently freed memory in use rather than splitting larger blocks
+        if (const auto [c, s] = class_of(size); c < classes) {
+            if (block* b = free_lists_[c][s]; b && size_of(b) >= size) {
+                remove_free_block(b);
+                return b;
+            }
+        }
+
+        auto [c, s] = class_at_least(size);
+        if (c >= classes) {
             throw std::bad_alloc();
         }
+        std::uint32_t sub_map =
+            sub_class_bitmaps_[c] & (~std::uint32_t{0} << s);
+        if (! sub_map) {
+            const std::uint64_t map =
+                c + 1 < 64 ? class_bitmap_ & (~std::uint64_t{0} << (c + 1))
+                           : 0;
+            if (! map) {
+                throw std::bad_alloc();
+            }
+            c = std::countr_zero(map);
+            sub_map = sub_class_bitmaps_[c];
+        }
+        s = std::countr_zero(sub_map);
 
-        block* new_block = reinterpret_cast<block*>(memory_pool_ + offset_);
-        new_block->size = pool_size_ - offset_ - sizeof(block);
-        new_block->next = nullptr;
+        block* b = free_lists_[c][s];
+        remove_free_block(b);
+        return b;
+    }
 
-        // Update free list to point to the new block
-        free_list_ = new_block;
+    // Split b at offset, returning the block starting at offset
+    block* split(block* b, std::size_t offset) {
+        block* rest = reinterpret_cast<block*>(reinterpret_cast<char*>(b) +
+                                               offset);
+        rest->prev_size = offset;
+        rest->size = size_of(b) - offset;
+        next_block(rest)->prev_size = rest->size;
+        b->size = offset;
+        return rest;
+    }
 
-        // Update offset to the next available address
-        offset_ += block_size;
+    block* merge(block* b, block* next) {
+        b->size = size_of(b) + size_of(next);
+        next_block(b)->prev_size = b->size;
+        return b;
+    }
 
-        // Return the address immediately after the block metadata
-        return reinterpret_cast<void*>(reinterpret_cast<char*>(new_block) +
-                                       sizeof(block));
+    // Trim b to size, returning the remainder to the free lists
+    void* use(block* b, std::size_t size) {
+        if (size_of(b) - size >= min_block_size) {
+            insert_free_block(split(b, size));
+        }
+        return payload_of(b);
     }
 };
 
@@ -103,7 +292,7 @@ class pool_allocator {
         : memory_pool_(memory_pool) {}
 
     T* allocate(std::size_t n) {
-        void* memory = memory_pool_.allocate(n * sizeof(T));
+        void* memory = memory_pool_.allocate(n * sizeof(T), alignof(T));
         if (! memory) {
             throw std::bad_alloc();
         }
@@ -118,4 +307,4 @@ class pool_allocator {
     memory_pool<PoolSize>& memory_pool_;
 };
 
-}  // namespace kcu
\ No newline at end of file
+}  // namespace kcu
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
 namespace kcu {
@@ -7,53 +9,102 @@ namespace kcu {
 template <typename T>
 struct default_delete final {
     constexpr default_delete() noexcept = default;
+
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    default_delete(const default_delete<U>&) noexcept {}
+
     void operator()(T* ptr) const { delete ptr; }
 };
 
+template <typename T>
+struct default_delete<T[]> final {
+    constexpr default_delete() noexcept = default;
+    void operator()(T* ptr) const { delete[] ptr; }
+};
+
+// Owning pointer. A stateless deleter such as default_delete takes no space,
+// so unique_ptr<T> is the size of a T*. unique_ptr<T[]> owns an array, deleted
+// with delete[] and indexed with operator[]. Deleter may be a reference type.
 template <typename T, typename Deleter = default_delete<T>>
 class unique_ptr final {
    public:
-    unique_ptr(T* ptr, Deleter&& del = default_delete<T>{})
-        : ptr_(ptr), del_(std::forward<Deleter>(del)) {}
+    using element_type = std::remove_extent_t<T>;
+    using pointer = element_type*;
+    using deleter_type = Deleter;
+
+    constexpr unique_ptr() noexcept
+        requires std::is_default_constructible_v<Deleter>
+    = default;
+
+    unique_ptr(pointer ptr) noexcept
+        requires std::is_default_constructible_v<Deleter>
+        : ptr_(ptr) {}
+
+    template <typename D>
+        requires std::is_constructible_v<Deleter, D&&>
+    unique_ptr(pointer ptr, D&& del) noexcept
+        : ptr_(ptr), del_(std::forward<D>(del)) {}
+
+    unique_ptr(unique_ptr&& u) noexcept
+        : ptr_(u.release()), del_(std::forward<Deleter>(u.get_deleter())) {}
+
+    // From a pointer to a derived class
+    template <typename U, typename E>
+        requires(! std::is_array_v<T> && ! std::is_array_v<U> &&
+                 std::is_convertible_v<U*, T*> &&
+                 std::is_constructible_v<Deleter, E &&>)
+    unique_ptr(unique_ptr<U, E>&& u) noexcept
+        : ptr_(u.release()), del_(std::forward<E>(u.get_deleter())) {}
+
     unique_ptr& operator=(unique_ptr&& u) noexcept {
-        (*this).swap(std::move(u));
+        reset(u.release());
+        del_ = std::forward<Deleter>(u.get_deleter());
         return *this;
     }
-    unique_ptr(unique_ptr&& u) noexcept { (*this).swap(std::move(u)); }
+
     unique_ptr(const unique_ptr& u) = delete;
     unique_ptr& operator=(const unique_ptr& u) = delete;
     ~unique_ptr() { reset(); }
 
-    void swap(unique_ptr&& u) {
+    void swap(unique_ptr& u) noexcept {
         std::swap(ptr_, u.ptr_);
         std::swap(del_, u.del_);
     }
 
-    T* release() {
-        T* new_ptr = nullptr;
-        swap(new_ptr, this);
-        return new_ptr;
-    }
+    // Give up ownership without deleting
+    pointer release() noexcept { return std::exchange(ptr_, nullptr); }
 
-    void reset(T* new_ptr = nullptr) {
-        if (ptr_ != new_ptr) {
-            del_(ptr_);
-            ptr_ = new_ptr;
+    void reset(pointer new_ptr = nullptr) {
+        if (pointer old = std::exchange(ptr_, new_ptr)) {
+            del_(old);
         }
     }
 
-    T* get() const { return ptr_; }
-    T* operator->() const { return ptr_; }
-    T& operator*() const { return *ptr_; }
-    explicit operator bool() const { return ptr_; }
+    pointer get() const noexcept { return ptr_; }
+    Deleter& get_deleter() noexcept { return del_; }
+    const Deleter& get_deleter() const noexcept { return del_; }
+    explicit operator bool() const noexcept { return ptr_; }
 
-    template <typename T1, typename D1, typename T2, typename D2>
-    friend bool operator==(const unique_ptr<T1, D1>& u1,
-                           const unique_ptr<T2, D2>& u2);
+    pointer operator->() const noexcept
+        requires(! std::is_array_v<T>)
+    {
+        return ptr_;
+    }
+    element_type& operator*() const
+        requires(! std::is_array_v<T>)
+    {
+        return *ptr_;
+    }
+    element_type& operator[](std::size_t i) const
+        requires std::is_array_v<T>
+    {
+        return ptr_[i];
+    }
 
    private:
-    T* ptr_;
-    Deleter del_;
+    pointer ptr_ = nullptr;
+    [[no_unique_address]] Deleter del_;
 };
 
 template <typename T1, typename D1, typename T2, typename D2>
@@ -61,9 +112,22 @@ bool operator==(const unique_ptr<T1, D1>& u1, const unique_ptr<T2, D2>& u2) {
     return u1.get() == u2.get();
 }
 
+template <typename T, typename D>
+bool operator==(const unique_ptr<T, D>& u, std::nullptr_t) {
+    return ! u;
+}
+
 template <typename T, typename... Args>
+    requires(! std::is_array_v<T>)
 unique_ptr<T> make_unique(Args&&... args) {
     return unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
-}  // namespace kcu
\ No newline at end of file
+// Array of n value initialised elements
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+unique_ptr<T> make_unique(std::size_t n) {
+    return unique_ptr<T>(new std::remove_extent_t<T>[n]());
+}
+
+}  // namespace kcu
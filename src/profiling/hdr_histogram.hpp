@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace kcu {
+
+// Histogram of non-negative integer values, e.g. latencies in nanoseconds,
+// for percentile queries such as p99 and p999 rather than averages. Values
+// are counted in log-linear buckets: values below 2^sub_bucket_bits exactly,
+// larger ones in buckets whose width is at most 1/128 of their values, so a
+// reported percentile is within 0.8% of the recorded value. Any uint64 value
+// can be recorded, and the buckets are allocated once, at construction.
+//
+// record() may be called from any number of threads at once and takes a few
+// relaxed atomic updates. Heavily shared histograms contend on the popular
+// buckets, so hot paths should record into one histogram per thread and
+// merge them for reporting. Queries may run concurrently with recording and
+// then include some of the values being recorded.
+class hdr_histogram {
+   public:
+    static constexpr unsigned sub_bucket_bits = 8;
+    static constexpr std::size_t bucket_count =
+        std::size_t(64 - sub_bucket_bits + 2) << (sub_bucket_bits - 1);
+
+    hdr_histogram()
+        : counts_(new std::atomic<std::uint64_t>[bucket_count]()) {}
+
+    hdr_histogram(const hdr_histogram& other) : hdr_histogram() {
+        *this += other;
+    }
+
+    hdr_histogram& operator=(const hdr_histogram& other) {
+        if (this != &other) {
+            reset();
+            *this += other;
+        }
+        return *this;
+    }
+
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept {
+        counts_[bucket_of(value)].fetch_add(count, std::memory_order_relaxed);
+        sum_.fetch_add(value * count, std::memory_order_relaxed);
+        update_min(value);
+        update_max(value);
+    }
+
+    // Durations are recorded in nanoseconds, negative ones as 0
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) noexcept {
+        const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        record(static_cast<std::uint64_t>(std::max<decltype(ns)>(ns, 0)));
+    }
+
+    // Add the counts of another histogram, e.g. one per recording thread
+    hdr_histogram& operator+=(const hdr_histogram& other) noexcept {
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            if (auto n = other.counts_[i].load(std::memory_order_relaxed)) {
+                counts_[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        sum_.fetch_add(other.sum_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+        update_min(other.min_.load(std::memory_order_relaxed));
+        update_max(other.max_.load(std::memory_order_relaxed));
+        return *this;
+    }
+
+    void reset() noexcept {
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            counts_[i].store(0, std::memory_order_relaxed);
+        }
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<std::uint64_t>::max(),
+                   std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const noexcept {
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            total += counts_[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Exact smallest and largest values recorded, 0 if empty
+    std::uint64_t min() const noexcept {
+        const auto m = min_.load(std::memory_order_relaxed);
+        return m == std::numeric_limits<std::uint64_t>::max() ? 0 : m;
+    }
+
+    std::uint64_t max() const noexcept {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    double mean() const noexcept {
+        const auto n = count();
+        return n ? double(sum_.load(std::memory_order_relaxed)) / double(n)
+                 : 0.0;
+    }
+
+    // Smallest value such that percentile % of the recorded values are at
+    // most it, up to the bucket resolution. 0 if empty.
+    std::uint64_t value_at_percentile(double percentile) const noexcept {
+        const auto total = count();
+        if (total == 0) {
+            return 0;
+        }
+        const double p = std::clamp(percentile, 0.0, 100.0);
+        const auto rank = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * total)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::clamp(highest_in_bucket(i), min(), max());
+            }
+        }
+        return max();
+    }
+
+    std::uint64_t p50() const noexcept { return value_at_percentile(50.0); }
+    std::uint64_t p99() const noexcept { return value_at_percentile(99.0); }
+    std::uint64_t p999() const noexcept { return value_at_percentile(99.9); }
+
+    // Bucket layout: the bucket counting a value, and the range of values
+    // each bucket counts
+    static std::size_t bucket_of(std::uint64_t value) noexcept {
+        if (value < (std::uint64_t(1) << sub_bucket_bits)) {
+            return value;
+        }
+        // Keep the top sub_bucket_bits bits, the leading one included
+        const unsigned shift = std::bit_width(value) - sub_bucket_bits;
+        return (std::size_t(shift) << (sub_bucket_bits - 1)) +
+               (value >> shift);
+    }
+
+    static std::uint64_t lowest_in_bucket(std::size_t bucket) noexcept {
+        if (bucket < (std::size_t(1) << sub_bucket_bits)) {
+            return bucket;
+        }
+        const unsigned shift = (bucket >> (sub_bucket_bits - 1)) - 1;
+        return std::uint64_t(bucket - (std::size_t(shift)
+                                       << (sub_bucket_bits - 1)))
+               << shift;
+    }
+
+    static std::uint64_t highest_in_bucket(std::size_t bucket) noexcept {
+        if (bucket < (std::size_t(1) << sub_bucket_bits)) {
+            return bucket;
+        }
+        const unsigned shift = (bucket >> (sub_bucket_bits - 1)) - 1;
+        return lowest_in_bucket(bucket) + ((std::uint64_t(1) << shift) - 1);
+    }
+
+   private:
+    void update_min(std::uint64_t value) noexcept {
+        auto current = min_.load(std::memory_order_relaxed);
+        while (value < current &&
+               ! min_.compare_exchange_weak(current, value,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    void update_max(std::uint64_t value) noexcept {
+        auto current = max_.load(std::memory_order_relaxed);
+        while (value > current &&
+               ! max_.compare_exchange_weak(current, value,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> counts_;
+    std::atomic<std::uint64_t> sum_ = 0;
+    std::atomic<std::uint64_t> min_ =
+        std::numeric_limits<std::uint64_t>::max();
+    std::atomic<std::uint64_t> max_ = 0;
+};
+
+}  // namespace kcu
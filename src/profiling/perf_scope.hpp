@@ -0,0 +1,156 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace kcu {
+
+// Hardware and software event counts over a perf_scope. A counter the kernel
+// did not allow (see /proc/sys/kernel/perf_event_paranoid) or the CPU does
+// not have, e.g. in most virtual machines, is empty.
+struct perf_counts {
+    std::optional<std::uint64_t> cycles;
+    std::optional<std::uint64_t> instructions;
+    std::optional<std::uint64_t> cache_misses;
+    std::optional<std::uint64_t> branch_misses;
+    std::optional<std::uint64_t> context_switches;
+
+    // Instructions per cycle
+    std::optional<double> ipc() const {
+        if (! cycles || ! instructions || *cycles == 0) {
+            return std::nullopt;
+        }
+        return double(*instructions) / double(*cycles);
+    }
+};
+
+// Counts cycles, instructions, last level cache misses and branch misses in
+// user space, and context switches, of the calling thread through Linux
+// perf_event_open, from construction (or the last reset) until counts() is
+// called. Opening the counters costs a few system calls, reading each one a
+// system call, so scopes should enclose work of at least microseconds.
+//
+// Counters the kernel refuses are left out rather than reported as errors.
+// When more hardware counters are in use than the CPU has, the kernel
+// multiplexes them and counts are scaled up from the time they were running.
+class perf_scope {
+    enum event {
+        cycles,
+        instructions,
+        cache_misses,
+        branch_misses,
+        context_switches,
+        num_events
+    };
+
+    struct reading {
+        std::uint64_t value = 0;
+        std::uint64_t time_enabled = 0;
+        std::uint64_t time_running = 0;
+    };
+
+   public:
+    perf_scope() {
+        fds_[cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[instructions] =
+            open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[cache_misses] =
+            open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds_[branch_misses] =
+            open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds_[context_switches] =
+            open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+        reset();
+    }
+
+    perf_scope(const perf_scope&) = delete;
+    perf_scope& operator=(const perf_scope&) = delete;
+
+    ~perf_scope() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    // Whether any counter could be opened
+    bool available() const noexcept {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Count from now on
+    void reset() noexcept {
+        for (std::size_t i = 0; i < num_events; ++i) {
+            start_[i] = read(fds_[i]);
+        }
+    }
+
+    perf_counts counts() const noexcept {
+        std::array<std::optional<std::uint64_t>, num_events> deltas;
+        for (std::size_t i = 0; i < num_events; ++i) {
+            if (fds_[i] >= 0) {
+                // Scaling estimates may make a multiplexed count go back
+                const auto start = scaled(start_[i]);
+                const auto end = scaled(read(fds_[i]));
+                deltas[i] = end > start ? end - start : 0;
+            }
+        }
+        return {deltas[cycles], deltas[instructions], deltas[cache_misses],
+                deltas[branch_misses], deltas[context_switches]};
+    }
+
+   private:
+    static int open(std::uint32_t type, std::uint64_t config) noexcept {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Hardware events in user space only, which unprivileged processes
+        // may count with the default perf_event_paranoid of 2. Context
+        // switches happen in the kernel, so would never be counted.
+        if (type == PERF_TYPE_HARDWARE) {
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+        }
+        // pid 0 and cpu -1: the calling thread, on whichever CPU it runs
+        const long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return static_cast<int>(fd);
+    }
+
+    static reading read(int fd) noexcept {
+        reading r;
+        if (fd >= 0 && ::read(fd, &r, sizeof(r)) != sizeof(r)) {
+            r = {};
+        }
+        return r;
+    }
+
+    static std::uint64_t scaled(const reading& r) noexcept {
+        if (r.time_running == 0 || r.time_running == r.time_enabled) {
+            return r.value;
+        }
+        return static_cast<std::uint64_t>(double(r.value) *
+                                          double(r.time_enabled) /
+                                          double(r.time_running));
+    }
+
+    std::array<int, num_events> fds_;
+    std::array<reading, num_events> start_;
+};
+
+}  // namespace kcu
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Timeline tracing: spans and instant events recorded into per-thread ring
+// buffers and exported as Chrome trace_event JSON, which Perfetto
+// (ui.perfetto.dev) and chrome://tracing display.
+//
+// Recording is off until tracing::start(). While off, an instrumentation
+// point costs a relaxed load and a branch; while on, an event costs a TSC
+// read (two for a span) and a few stores into the thread's ring buffer.
+// Event names must be string literals or otherwise outlive the export.
+// Define KCU_DISABLE_TRACING to compile every instrumentation point out.
+#ifdef KCU_DISABLE_TRACING
+#define KCU_TRACE_SCOPE(name) ((void)0)
+#define KCU_TRACE_INSTANT(name) ((void)0)
+#else
+#define KCU_TRACE_CONCAT_IMPL(a, b) a##b
+#define KCU_TRACE_CONCAT(a, b) KCU_TRACE_CONCAT_IMPL(a, b)
+#define KCU_TRACE_SCOPE(name) \
+    ::kcu::tracing::scope KCU_TRACE_CONCAT(kcu_trace_scope_, __LINE__)(name)
+#define KCU_TRACE_INSTANT(name) ::kcu::tracing::instant(name)
+#endif
+
+namespace kcu::tracing {
+
+#ifdef KCU_DISABLE_TRACING
+inline constexpr bool compiled_in = false;
+#else
+inline constexpr bool compiled_in = true;
+#endif
+
+// Slots per thread. Older events are overwritten, and the exporter reports
+// the latest buffer_events - 1, as the oldest slot may be being overwritten.
+inline constexpr std::size_t buffer_events = 1 << 13;
+
+namespace detail {
+
+    enum class phase : std::uint32_t { complete, instant };
+
+    // Fields are relaxed atomics so that exporting while threads record is
+    // not a data race; on x86 they compile to plain stores
+    struct event {
+        std::atomic<std::uint64_t> start;
+        std::atomic<std::uint64_t> end;
+        std::atomic<const char*> name;
+        // Thread id in the high half, phase in the low half
+        std::atomic<std::uint64_t> tid_phase;
+    };
+
+    // Written by one thread at a time, read by the exporter. head counts
+    // every event written; slot head % buffer_events is the next one.
+    // Events before cleared were dropped by tracing::clear().
+    struct thread_buffer {
+        std::atomic<std::uint64_t> head = 0;
+        std::atomic<std::uint64_t> cleared = 0;
+        std::uint32_t tid = 0;
+        std::unique_ptr<event[]> events{new event[buffer_events]};
+    };
+
+    class registry {
+       public:
+        static registry& instance() {
+            // Never destroyed, threads may record while the process exits
+            static registry* r = new registry;
+            return *r;
+        }
+
+        std::atomic<bool> enabled = false;
+
+        thread_buffer* acquire(std::uint32_t tid) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            thread_buffer* buffer;
+            // Buffers of exited threads are reused, their events stay until
+            // overwritten and are still attributed to the old thread id
+            if (! free_.empty()) {
+                buffer = free_.back();
+                free_.pop_back();
+            } else {
+                buffers_.push_back(std::make_unique<thread_buffer>());
+                buffer = buffers_.back().get();
+            }
+            buffer->tid = tid;
+            return buffer;
+        }
+
+        void release(thread_buffer* buffer) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(buffer);
+        }
+
+        void set_thread_name(std::uint32_t tid, std::string name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            thread_names_[tid] = std::move(name);
+        }
+
+        std::uint32_t next_tid() {
+            return next_tid_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename F>
+        void for_each_buffer(F&& f) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& buffer : buffers_) {
+                f(*buffer);
+            }
+        }
+
+        std::map<std::uint32_t, std::string> thread_names() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return thread_names_;
+        }
+
+        // Timestamps at the first event, to convert ticks to microseconds
+        const std::uint64_t origin_ticks;
+        const std::chrono::steady_clock::time_point origin_time;
+
+       private:
+        registry();
+
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<thread_buffer>> buffers_;
+        std::vector<thread_buffer*> free_;
+        std::map<std::uint32_t, std::string> thread_names_;
+        std::atomic<std::uint32_t> next_tid_ = 1;
+    };
+
+    // The calling thread's buffer, acquired on its first event
+    class local_buffer {
+       public:
+        static local_buffer& get() {
+            static thread_local local_buffer local;
+            return local;
+        }
+
+        std::uint32_t tid() {
+            if (tid_ == 0) {
+                tid_ = registry::instance().next_tid();
+            }
+            return tid_;
+        }
+
+        thread_buffer& buffer() {
+            if (! buffer_) {
+                buffer_ = registry::instance().acquire(tid());
+            }
+            return *buffer_;
+        }
+
+        ~local_buffer() {
+            if (buffer_) {
+                registry::instance().release(buffer_);
+            }
+        }
+
+       private:
+        std::uint32_t tid_ = 0;
+        thread_buffer* buffer_ = nullptr;
+    };
+
+}  // namespace detail
+
+// Timestamp in ticks: the TSC on x86, nanoseconds elsewhere
+inline std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+inline detail::registry::registry()
+    : origin_ticks(now()), origin_time(std::chrono::steady_clock::now()) {}
+
+inline bool enabled() noexcept {
+    if constexpr (compiled_in) {
+        return detail::registry::instance().enabled.load(
+            std::memory_order_relaxed);
+    } else {
+        return false;
+    }
+}
+
+// Start or stop recording events, from all threads
+inline void start() {
+    if constexpr (compiled_in) {
+        detail::registry::instance().enabled.store(true);
+    }
+}
+
+inline void stop() {
+    if constexpr (compiled_in) {
+        detail::registry::instance().enabled.store(false);
+    }
+}
+
+namespace detail {
+
+    inline void record(const char* name, std::uint64_t start,
+                       std::uint64_t end, phase ph) noexcept {
+        auto& buffer = local_buffer::get().buffer();
+        const auto head = buffer.head.load(std::memory_order_relaxed);
+        auto& e = buffer.events[head % buffer_events];
+        // Orders the stores after the last head update, so an exporter that
+        // reads any of them also sees the slot's previous event as stale
+        std::atomic_thread_fence(std::memory_order_release);
+        e.start.store(start, std::memory_order_relaxed);
+        e.end.store(end, std::memory_order_relaxed);
+        e.name.store(name, std::memory_order_relaxed);
+        e.tid_phase.store(std::uint64_t(buffer.tid) << 32 | std::uint32_t(ph),
+                          std::memory_order_relaxed);
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+}  // namespace detail
+
+// Record a span from start to end, e.g. from a timestamp taken on another
+// thread, such as the time a task was queued
+inline void complete(const char* name, std::uint64_t start,
+                     std::uint64_t end = now()) noexcept {
+    if (enabled()) {
+        detail::record(name, start, end, detail::phase::complete);
+    }
+}
+
+inline void instant(const char* name) noexcept {
+    if (enabled()) {
+        const auto t = now();
+        detail::record(name, t, t, detail::phase::instant);
+    }
+}
+
+// Span from construction to destruction, recorded if tracing was enabled at
+// construction
+class scope {
+   public:
+    explicit scope(const char* name) noexcept
+        : name_(name), start_(enabled() ? now() : 0) {}
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+    ~scope() {
+        if (start_) {
+            complete(name_, start_);
+        }
+    }
+
+   private:
+    const char* name_;
+    std::uint64_t start_;
+};
+
+// Name the calling thread in exported traces
+inline void set_thread_name(std::string name) {
+    if constexpr (compiled_in) {
+        detail::registry::instance().set_thread_name(
+            detail::local_buffer::get().tid(), std::move(name));
+    }
+}
+
+// Drop the events recorded so far
+inline void clear() {
+    detail::registry::instance().for_each_buffer(
+        [](detail::thread_buffer& buffer) {
+            buffer.cleared.store(buffer.head.load(std::memory_order_acquire),
+                                 std::memory_order_relaxed);
+        });
+}
+
+namespace detail {
+
+    inline void write_json_string(std::ostream& os, const char* s) {
+        os << '"';
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') {
+                os << '\\' << *s;
+            } else if (static_cast<unsigned char>(*s) < 0x20) {
+                os << ' ';
+            } else {
+                os << *s;
+            }
+        }
+        os << '"';
+    }
+
+    // Microseconds per tick, measured against the steady clock since the
+    // first event
+    inline double microseconds_per_tick() {
+        auto& r = registry::instance();
+        auto elapsed = std::chrono::steady_clock::now() - r.origin_time;
+        // Too short an interval gives a poor estimate
+        if (elapsed < std::chrono::milliseconds(10)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10) -
+                                        elapsed);
+            elapsed = std::chrono::steady_clock::now() - r.origin_time;
+        }
+        const auto ticks = now() - r.origin_ticks;
+        const std::chrono::duration<double, std::micro> us = elapsed;
+        return ticks ? us.count() / double(ticks) : 0.0;
+    }
+
+}  // namespace detail
+
+// Write the recorded events as Chrome trace_event JSON. Threads may keep
+// recording meanwhile; events they overwrite during the export are left out.
+inline void write_chrome_trace(std::ostream& os) {
+    auto& r = detail::registry::instance();
+    const double us_per_tick = detail::microseconds_per_tick();
+    const auto to_us = [&](std::uint64_t ticks) {
+        return ticks > r.origin_ticks
+                   ? double(ticks - r.origin_ticks) * us_per_tick
+                   : 0.0;
+    };
+
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    const auto separator = [&]() {
+        if (! first) {
+            os << ',';
+        }
+        first = false;
+        os << '\n';
+    };
+
+    for (const auto& [tid, name] : r.thread_names()) {
+        separator();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << tid << ",\"args\":{\"name\":";
+        detail::write_json_string(os, name.c_str());
+        os << "}}";
+    }
+
+    r.for_each_buffer([&](detail::thread_buffer& buffer) {
+        const auto head = buffer.head.load(std::memory_order_acquire);
+        auto i = head >= buffer_events ? head - buffer_events + 1 : 0;
+        i = std::max(i, buffer.cleared.load(std::memory_order_relaxed));
+        for (; i < head; ++i) {
+            const auto& e = buffer.events[i % buffer_events];
+            const auto start = e.start.load(std::memory_order_relaxed);
+            const auto end = e.end.load(std::memory_order_relaxed);
+            const char* name = e.name.load(std::memory_order_relaxed);
+            const auto tid_phase = e.tid_phase.load(std::memory_order_relaxed);
+            // Skip the slot if its owner has since started overwriting it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (i + buffer_events <=
+                buffer.head.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            const auto phase = detail::phase(tid_phase & 0xffffffff);
+            separator();
+            os << "{\"name\":";
+            detail::write_json_string(os, name);
+            if (phase == detail::phase::complete) {
+                os << ",\"ph\":\"X\",\"ts\":" << to_us(start)
+                   << ",\"dur\":" << std::max(0.0, to_us(end) - to_us(start));
+            } else {
+                os << ",\"ph\":\"i\",\"ts\":" << to_us(start)
+                   << ",\"s\":\"t\"";
+            }
+            os << ",\"pid\":1,\"tid\":" << (tid_phase >> 32) << '}';
+        }
+    });
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+}  // namespace kcu::tracing